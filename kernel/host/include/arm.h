@@ -0,0 +1,73 @@
+/** @file arm.h
+ *
+ *  @brief  Host simulator replacement for kernel/include/arm.h.
+ *
+ *          Same interface, but interrupt masking, PendSV and the SVC status
+ *          act on the simulated core in host_sim.c instead of on hardware
+ *          registers. The Makefile puts this directory first on the include
+ *          path for host builds, so kernel sources pick it up unmodified.
+ */
+#ifndef _ARM_H_
+#define _ARM_H_
+
+#define intrinsic __attribute__( ( always_inline ) ) static inline
+
+/** @brief      Code placement is meaningless on the host. */
+#define RAMFUNC
+
+#include <unistd.h>
+#include <stdint.h>
+
+void init_349( void );
+
+void enable_fpu( void );
+
+#include "exclusive.h"
+
+/**
+ * @brief      Simulated PRIMASK, see host_sim.c.
+ */
+//@{
+void enable_interrupts( void );
+
+void disable_interrupts( void );
+
+int save_interrupt_state_and_disable( void );
+
+void restore_interrupt_state( int state );
+//@}
+
+/**
+ * @brief      Aborts the simulation.
+ */
+void breakpoint( void );
+
+/**
+ * @brief      Barriers are no-ops on the simulated core.
+ */
+//@{
+intrinsic void data_sync_barrier( void ) {
+  __asm volatile( "" ::: "memory" );
+}
+
+intrinsic void instruction_sync_barrier( void ) {
+  __asm volatile( "" ::: "memory" );
+}
+//@}
+
+/**
+ * @brief      Advances virtual time to the next tick and delivers it.
+ */
+void wait_for_interrupt( void );
+
+void pend_pendsv( void );
+
+void clear_pendsv( void );
+
+int get_svc_status( void );
+
+void set_svc_status( int status );
+
+#undef intrinsic
+
+#endif /* _ARM_H_ */
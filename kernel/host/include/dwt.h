@@ -0,0 +1,17 @@
+/** @file dwt.h
+ *
+ *  @brief  Host simulator replacement for kernel/include/dwt.h. The cycle
+ *          counter reads the simulator's virtual cycle count.
+ */
+#ifndef _DWT_H_
+#define _DWT_H_
+
+#include <unistd.h>
+#include <stdint.h>
+
+/**
+ * @brief      Reads the low 32 bits of the virtual cycle count.
+ */
+uint32_t dwt_get_cycles( void );
+
+#endif /* _DWT_H_ */
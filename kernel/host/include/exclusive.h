@@ -0,0 +1,27 @@
+/** @file exclusive.h
+ *
+ *  @brief  Host simulator replacement for kernel/include/exclusive.h.
+ *
+ *          Exclusive accesses never fail on the single host core.
+ */
+#ifndef _EXCLUSIVE_H_
+#define _EXCLUSIVE_H_
+
+#include <stdint.h>
+
+__attribute__( ( always_inline ) ) static inline
+uint32_t store_exclusive_register( uint32_t *addr, uint32_t val ) {
+  *addr = val;
+  return 0;
+}
+
+__attribute__( ( always_inline ) ) static inline
+uint32_t load_exclusive_register( uint32_t *addr ) {
+  return *addr;
+}
+
+__attribute__( ( always_inline ) ) static inline
+void clear_exclusive( void ) {
+}
+
+#endif /* _EXCLUSIVE_H_ */
@@ -0,0 +1,87 @@
+/** @file host_sim.h
+ *
+ *  @brief  Simulated Cortex-M core for running the kernel on a Linux host.
+ *
+ *          The kernel and the user program are linked into one host process.
+ *          Time is virtual: a cycle counter advances by a fixed cost for every
+ *          system call and UART byte, and SysTick fires whenever the counter
+ *          crosses the next reload. Threads are ucontexts, switched only by
+ *          the PendSV emulation, so a run depends on nothing but the program
+ *          and its arguments.
+ *
+ *          Pure busy loops make no system calls and would never see a tick, so
+ *          a wall-clock SIGALRM also delivers the next tick when it lands in
+ *          user code outside a critical section and no system call has been
+ *          made since the previous alarm. That path only fires in code that
+ *          makes no observable progress between ticks.
+ *
+ *          Faults are the signals SIGSEGV, SIGBUS, SIGILL and SIGFPE. One in a
+ *          user thread outside the kernel kills that thread as
+ *          fault_c_handler() would, and the scheduler carries on. Anywhere
+ *          else it ends the run, where the board would reset. There is no
+ *          crash log to keep across that.
+ */
+#ifndef _HOST_SIM_H_
+#define _HOST_SIM_H_
+
+#include <stdint.h>
+
+/** @brief      Virtual cycles charged for entering and leaving the kernel. */
+#define HOST_SYSCALL_CYCLES 200
+
+/** @brief      Environment variable that ends the run after this many ticks. */
+#define HOST_MAX_TICKS_ENV "HOST_MAX_TICKS"
+
+/**
+ * @brief      Marks entry into a system call.
+ */
+void host_syscall_enter( void );
+
+/**
+ * @brief      Marks the end of a system call and delivers whatever became
+ *             pending during it.
+ */
+void host_syscall_exit( void );
+
+/**
+ * @brief      Charges virtual cycles to the running code.
+ */
+void host_advance( uint64_t cycles );
+
+/**
+ * @brief      Reads the full virtual cycle count, which dwt_get_cycles()
+ *             truncates to 32 bits.
+ */
+uint64_t host_get_cycles( void );
+
+/**
+ * @brief      Starts or stops the simulated SysTick.
+ *
+ * @param[in]  period  Cycles per tick, 0 to stop.
+ */
+void host_systick_config( uint64_t period );
+
+/**
+ * @brief      Arms and disarms the simulated release timer compare, which
+ *             calls release_timer_irq_handler() once the cycle count reaches
+ *             at.
+ */
+//@{
+void host_compare_arm( uint64_t at );
+void host_compare_cancel( void );
+//@}
+
+/**
+ * @brief      Runs the user program's main() as the kernel's main thread.
+ */
+void host_run_user( void );
+
+/**
+ * @brief      Command line of the simulator, minus the options it consumed.
+ */
+//@{
+extern int host_argc;
+extern char **host_argv;
+//@}
+
+#endif /* _HOST_SIM_H_ */
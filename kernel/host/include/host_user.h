@@ -0,0 +1,42 @@
+/** @file host_user.h
+ *
+ *  @brief  Forced include for user programs in host simulator builds.
+ *
+ *          On the board, newlib's stdio and malloc sit on top of the SVC stubs.
+ *          On the host they are glibc, which must not be entered twice by
+ *          two simulated threads, so the calls a user program makes are
+ *          redirected to wrappers in host_user.c that run glibc with the
+ *          simulator's tick signal blocked and send output through sys_write.
+ *          The program's main() becomes user_main() (see the Makefile).
+ */
+#ifndef _HOST_USER_H_
+#define _HOST_USER_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int host_printf( const char *fmt, ... );
+int host_putchar( int c );
+int host_puts( const char *s );
+void *host_malloc( size_t size );
+void *host_calloc( size_t count, size_t size );
+void *host_realloc( void *ptr, size_t size );
+void host_free( void *ptr );
+void host_exit( int status ) __attribute__( ( noreturn ) );
+ssize_t host_write( int file, const void *ptr, size_t len );
+ssize_t host_read( int file, void *ptr, size_t len );
+
+#define printf host_printf
+#define putchar host_putchar
+#define puts host_puts
+#define malloc host_malloc
+#define calloc host_calloc
+#define realloc host_realloc
+#define free host_free
+#define exit host_exit
+#define write host_write
+#define read host_read
+
+#endif /* _HOST_USER_H_ */
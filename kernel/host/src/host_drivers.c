@@ -0,0 +1,213 @@
+/** @file   host_drivers.c
+ *
+ *  @brief  Host stand-ins for the board drivers: the clock tree is fixed at
+ *          the frequencies clock_init() would program, SysTick is the
+ *          simulator's virtual timer and the UART is stdio, charged at the
+ *          time a byte takes on the wire.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <arm.h>
+#include <clock.h>
+#include <fault.h>
+#include <host_sim.h>
+#include <mpu.h>
+#include <release_timer.h>
+#include <syscall_thread.h>
+#include <timer.h>
+#include <uart.h>
+
+/** @brief      Frame length of a UART byte: start, 8 data and stop bits. */
+#define UART_FRAME_BITS 10
+
+/** @brief      Clock frequencies, in Hz, set by clock_init(). */
+//@{
+static uint32_t sysclk_hz = CLOCK_HSI_HZ;
+static uint32_t pclk1_hz = CLOCK_HSI_HZ;
+//@}
+
+/** @brief      Virtual cycles charged per UART byte. */
+static uint64_t uart_byte_cycles;
+
+/** @brief      Tick count, see timer.c. */
+static uint32_t millis = 0;
+
+/** @brief      Cycle count release_timer_start() restarted the timebase at. */
+static uint64_t release_start_cycles = 0;
+
+/**
+ * @brief      SysTick counts the virtual cycles, see timer.c. timer_start()
+ *             records the cycle count it started at.
+ */
+//@{
+static uint32_t counter_hz = 0;
+static uint32_t tick_counts = 0;
+static uint64_t start_cycles = 0;
+//@}
+
+void init_349( void ) {
+}
+
+void enable_fpu( void ) {
+}
+
+int clock_init( uint32_t sysclk ) {
+  if ( sysclk < CLOCK_HSI_HZ || sysclk > CLOCK_SYSCLK_MAX_HZ ) {
+    return -1;
+  }
+  sysclk_hz = sysclk;
+  pclk1_hz = sysclk > CLOCK_PCLK1_MAX_HZ ? sysclk / 2 : sysclk;
+  return 0;
+}
+
+uint32_t clock_get_sysclk_hz( void ) {
+  return sysclk_hz;
+}
+
+uint32_t clock_get_hclk_hz( void ) {
+  return sysclk_hz;
+}
+
+uint32_t clock_get_pclk1_hz( void ) {
+  return pclk1_hz;
+}
+
+uint32_t clock_get_pclk2_hz( void ) {
+  return sysclk_hz;
+}
+
+int timer_start( int frequency ) {
+  if ( frequency <= 0 ) {
+    return -1;
+  }
+  millis = 0;
+  counter_hz = clock_get_hclk_hz();
+  tick_counts = counter_hz / frequency;
+  start_cycles = host_get_cycles();
+  host_systick_config( tick_counts );
+  return 0;
+}
+
+void timer_stop() {
+  host_systick_config( 0 );
+}
+
+uint32_t systick_get_millis() {
+  return millis;
+}
+
+uint64_t timer_get_counts( void ) {
+  return tick_counts ? host_get_cycles() - start_cycles : 0;
+}
+
+uint32_t timer_get_tick_counts( void ) {
+  return tick_counts;
+}
+
+void timer_sleep( uint32_t max_ticks ) {
+  // Virtual time already jumps to the next interrupt, whether it does any
+  // work or not, so there is nothing to save by skipping ticks.
+  ( void )max_ticks;
+  wait_for_interrupt();
+}
+
+uint64_t timer_get_us( void ) {
+  uint64_t counts = timer_get_counts();
+
+  if ( !counter_hz ) {
+    return 0;
+  }
+  return counts / counter_hz * 1000000 +
+         counts % counter_hz * 1000000 / counter_hz;
+}
+
+void systick_c_handler( uint32_t val, uint32_t *frame, uint32_t exc_return ) {
+  // There is no interrupt latency to measure in virtual time.
+  ( void )val; ( void )frame; ( void )exc_return;
+  cpu_isr_enter();
+  millis++;
+
+  sched_tick( millis );
+  cpu_isr_exit();
+}
+
+/**
+ * @brief      Virtual cycles per release timer count. HCLK is a whole number
+ *             of MHz whenever release_timer_start() succeeds.
+ */
+static uint64_t release_cycles_per_count( void ) {
+  return clock_get_hclk_hz() / RELEASE_TIMER_HZ;
+}
+
+int release_timer_start( void ) {
+  if ( clock_get_hclk_hz() % RELEASE_TIMER_HZ ) {
+    return -1;
+  }
+  release_start_cycles = host_get_cycles();
+  host_compare_cancel();
+  return 0;
+}
+
+void release_timer_stop( void ) {
+  host_compare_cancel();
+}
+
+uint32_t release_timer_now( void ) {
+  return ( uint32_t )( ( host_get_cycles() - release_start_cycles ) /
+                       release_cycles_per_count() );
+}
+
+void release_timer_arm( uint32_t at ) {
+  uint64_t now = ( host_get_cycles() - release_start_cycles ) /
+                 release_cycles_per_count();
+  int32_t ahead = ( int32_t )( at - ( uint32_t )now );
+
+  host_compare_arm( ahead <= 0 ? host_get_cycles()
+                               : release_start_cycles +
+                                 ( now + ahead ) * release_cycles_per_count() );
+}
+
+void release_timer_cancel( void ) {
+  host_compare_cancel();
+}
+
+void release_timer_irq_handler( void ) {
+  cpu_isr_enter();
+  release_timer_cancel();
+  sched_release_timer();
+  cpu_isr_exit();
+}
+
+void fault_report( void ) {
+  // Faults end the run or kill a thread in host_sim.c, which keeps no crash
+  // log, so there is nothing from before a reset to report.
+}
+
+void uart_init( int baud ) {
+  uart_byte_cycles = ( uint64_t )clock_get_hclk_hz() * UART_FRAME_BITS / baud;
+}
+
+int uart_put_byte( char c ) {
+  host_advance( uart_byte_cycles );
+  putchar( c );
+  return 0;
+}
+
+int uart_get_byte( char *c ) {
+  int byte = getchar();
+
+  // Nothing will ever arrive, so a blocked read would spin forever.
+  if ( byte == EOF ) {
+    fflush( stdout );
+    fprintf( stderr, "[host] end of input\n" );
+    exit( 0 );
+  }
+  *c = ( char )byte;
+  return 0;
+}
+
+void uart_flush() {
+  fflush( stdout );
+}
@@ -0,0 +1,433 @@
+/** @file   host_sim.c
+ *
+ *  @brief  Simulated core: virtual time, PRIMASK, SysTick, PendSV and thread
+ *          contexts. See host_sim.h for the model.
+ */
+
+#define _GNU_SOURCE
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <ucontext.h>
+
+#include <arm.h>
+#include <boot_time.h>
+#include <context.h>
+#include <dwt.h>
+#include <host_sim.h>
+#include <kernel.h>
+#include <printk.h>
+#include <release_timer.h>
+#include <syscall_thread.h>
+#include <timer.h>
+
+/** @brief      Host stack for each simulated thread. Thread stacks on the
+ *              board are a few hundred bytes, too small for glibc. */
+#define HOST_STACK_SIZE ( 64 * 1024 )
+
+/** @brief      Thread contexts, enough for every TCB in syscall_thread.c. */
+#define HOST_MAX_CONTEXTS 40
+
+/** @brief      Wall-clock period of the busy loop fallback, in microseconds. */
+#define HOST_ALARM_US 50
+
+/** @brief      Stack the fault signals are taken on, in case the fault was a
+ *              stack overflow. */
+#define HOST_FAULT_STACK_SIZE ( 64 * 1024 )
+
+/** @brief      Size of each simulated thread stack region. */
+#define HOST_STACK_REGION_SIZE "32768"
+
+/**
+ * @brief      The linker script symbols the kernel uses, laid out the same way:
+ *             each thread stack region aligned to its size, and the user heap.
+ */
+__asm__(
+  ".bss\n"
+  ".balign " HOST_STACK_REGION_SIZE "\n"
+  ".globl __thread_u_stacks_low\n"
+  "__thread_u_stacks_low:\n"
+  ".skip " HOST_STACK_REGION_SIZE "\n"
+  ".globl __thread_u_stacks_top\n"
+  "__thread_u_stacks_top:\n"
+  ".globl __thread_k_stacks_low\n"
+  "__thread_k_stacks_low:\n"
+  ".skip " HOST_STACK_REGION_SIZE "\n"
+  ".globl __thread_k_stacks_top\n"
+  "__thread_k_stacks_top:\n"
+  ".balign 8\n"
+  ".globl __heap_low\n"
+  "__heap_low:\n"
+  ".skip 4096\n"
+  ".globl __heap_top\n"
+  "__heap_top:\n"
+  ".text\n"
+);
+
+/**
+ * @struct host_context
+ *
+ * @brief      A simulated thread. The kernel only ever sees its address.
+ */
+typedef struct {
+  ucontext_t uc;      /**< Saved host state */
+  void *kstack_top;   /**< Kernel stack the context was built for */
+  char *stack;        /**< Host stack */
+  void ( *fn )( void * ); /**< Thread function */
+  void *vargp;        /**< Argument for fn */
+  void ( *exit_fn )( void ); /**< Called when fn returns */
+} host_context;
+
+/** @brief      Context of the kernel's main thread, the host's own stack. */
+static host_context main_context;
+
+/** @brief      Contexts handed out by context_init(). */
+static host_context contexts[ HOST_MAX_CONTEXTS ];
+
+/** @brief      Context that is running. */
+static host_context *volatile running = &main_context;
+
+/** @brief      Simulated core state. */
+//@{
+static volatile uint64_t cycles;
+static volatile uint64_t next_tick;
+static volatile uint64_t tick_period;
+static volatile uint64_t compare_at;
+static volatile int compare_armed;
+static volatile uint32_t ticks;
+static uint32_t max_ticks;
+static volatile int primask;
+static volatile int svc_active;
+static volatile int in_handler;
+static volatile int pendsv_pending;
+static volatile int polling;
+static volatile uint32_t syscalls;
+//@}
+
+int host_argc;
+char **host_argv;
+
+/**
+ * @brief      Ends the run once the tick budget from HOST_MAX_TICKS is spent.
+ */
+static void host_check_limit( void ) {
+  if ( max_ticks && ticks >= max_ticks ) {
+    fflush( stdout );
+    fprintf( stderr, "[host] stopped after %u ticks, %llu cycles\n",
+             ticks, ( unsigned long long )cycles );
+    exit( 0 );
+  }
+}
+
+/**
+ * @brief      Takes the pending PendSV.
+ */
+static void host_pendsv( void ) {
+  host_context *prev = running;
+  host_context *next;
+
+  pendsv_pending = 0;
+  // The handler stays active across the switch so the tick signal cannot
+  // land halfway through it. Whoever resumes next leaves it.
+  in_handler++;
+  next = pendsv_c_handler( prev );
+
+  if ( next != prev ) {
+    running = next;
+    swapcontext( &prev->uc, &next->uc );
+  }
+  in_handler--;
+}
+
+/**
+ * @brief      Takes every interrupt that is due, in priority order.
+ */
+static void host_poll( void ) {
+  polling++;
+  while ( !primask && !in_handler ) {
+    if ( tick_period && cycles >= next_tick ) {
+      next_tick += tick_period;
+      ticks++;
+      in_handler++;
+      systick_c_handler( 0, NULL, 0 );
+      in_handler--;
+      host_check_limit();
+    } else if ( pendsv_pending ) {
+      host_pendsv();
+    } else if ( compare_armed && cycles >= compare_at ) {
+      in_handler++;
+      release_timer_irq_handler();
+      in_handler--;
+    } else {
+      break;
+    }
+  }
+  polling--;
+}
+
+/**
+ * @brief      Moves time forward to the next timer interrupt, as an idle core
+ *             would.
+ */
+static void host_skip_to_next_event( void ) {
+  uint64_t next = tick_period ? next_tick : UINT64_MAX;
+
+  if ( compare_armed && compare_at < next ) {
+    next = compare_at;
+  }
+  if ( next != UINT64_MAX && cycles < next ) {
+    cycles = next;
+  }
+}
+
+/**
+ * @brief      Wall-clock fallback for busy loops, see host_sim.h.
+ */
+static void host_alarm( int sig ) {
+  static uint32_t last_syscalls;
+
+  ( void )sig;
+
+  // Code that made a system call since the last alarm is making progress in
+  // virtual time on its own.
+  if ( syscalls != last_syscalls ) {
+    last_syscalls = syscalls;
+    return;
+  }
+  if ( primask || in_handler || polling || svc_active ||
+       ( !tick_period && !compare_armed ) ) {
+    return;
+  }
+  host_skip_to_next_event();
+  host_poll();
+}
+
+/**
+ * @brief      Fault signal handler, see host_sim.h. Prints what
+ *             fault_c_handler() would, then takes the PendSV the kill pended
+ *             as host_pendsv() would, but never comes back to the dead
+ *             context.
+ */
+static void host_fault( int sig ) {
+  static uint32_t faults;
+  uint32_t thread = sched_current();
+  const char *name = sig == SIGILL || sig == SIGFPE ? "UsageFault"
+                   : sig == SIGBUS                  ? "BusFault"
+                                                    : "MemManage";
+  int in_kernel = primask || in_handler || polling || svc_active;
+  host_context *next;
+
+  // Exception entry: nothing else is taken until the switch below.
+  in_handler++;
+  printk( "Fault %u: %s in thread %u\n", faults++, name, thread );
+  if ( in_kernel || sched_fault_kill( &thread ) ) {
+    fflush( stdout );
+    fprintf( stderr, "[host] fault outside a user thread at %u ticks\n", ticks );
+    exit( 1 );
+  }
+  printk( "Thread %u killed\n", thread );
+
+  // Whoever resumes leaves the handler and the poll, see host_pendsv().
+  pendsv_pending = 0;
+  polling++;
+  next = pendsv_c_handler( running );
+  running = next;
+  setcontext( &next->uc );
+}
+
+/**
+ * @brief      First function of every simulated thread.
+ */
+static void host_thread_entry( void ) {
+  host_context *context = running;
+
+  // Leave the PendSV and the poll that switched here, see host_pendsv().
+  in_handler--;
+  polling--;
+  context->fn( context->vargp );
+  context->exit_fn();
+}
+
+void *context_init( void *kstack_top,
+                    void *ustack_top,
+                    void *fn,
+                    void *vargp,
+                    void *exit_fn ){
+  host_context *context = NULL;
+
+  ( void )ustack_top;
+
+  // Stacks are recycled, and so are the contexts built on them. A job on the
+  // shared stacks can be rebuilt where the one switching out finished, but
+  // that host stack is still running this code.
+  for ( int i = 0; i < HOST_MAX_CONTEXTS && !context; i++ ) {
+    if ( contexts[ i ].kstack_top == kstack_top && &contexts[ i ] != running ) {
+      context = &contexts[ i ];
+    }
+  }
+  for ( int i = 0; i < HOST_MAX_CONTEXTS && !context; i++ ) {
+    if ( !contexts[ i ].kstack_top ) {
+      context = &contexts[ i ];
+      context->kstack_top = kstack_top;
+      context->stack = malloc( HOST_STACK_SIZE );
+    }
+  }
+  if ( !context || !context->stack ) {
+    fprintf( stderr, "[host] out of thread contexts\n" );
+    abort();
+  }
+
+  context->fn = ( void ( * )( void * ) )fn;
+  context->vargp = vargp;
+  context->exit_fn = ( void ( * )( void ) )exit_fn;
+
+  getcontext( &context->uc );
+  sigemptyset( &context->uc.uc_sigmask );
+  context->uc.uc_stack.ss_sp = context->stack;
+  context->uc.uc_stack.ss_size = HOST_STACK_SIZE;
+  context->uc.uc_link = NULL;
+  makecontext( &context->uc, host_thread_entry, 0 );
+
+  return context;
+}
+
+void context_stack_limits( void *context, void **kstack_top, void **ustack_top ){
+  // Host contexts have their own stacks. The context's address still tells
+  // context_init() which one to reuse.
+  *kstack_top = context;
+  *ustack_top = NULL;
+}
+
+void host_syscall_enter( void ) {
+  cycles += HOST_SYSCALL_CYCLES;
+  syscalls++;
+  svc_active = 1;
+}
+
+void host_syscall_exit( void ) {
+  svc_active = 0;
+  host_poll();
+}
+
+void host_advance( uint64_t n ) {
+  cycles += n;
+}
+
+uint64_t host_get_cycles( void ) {
+  return cycles;
+}
+
+void host_systick_config( uint64_t period ) {
+  tick_period = period;
+  next_tick = cycles + period;
+}
+
+void host_compare_arm( uint64_t at ) {
+  compare_at = at;
+  compare_armed = 1;
+}
+
+void host_compare_cancel( void ) {
+  compare_armed = 0;
+}
+
+uint32_t dwt_get_cycles( void ) {
+  return ( uint32_t )cycles;
+}
+
+void enable_interrupts( void ) {
+  primask = 0;
+  host_poll();
+}
+
+void disable_interrupts( void ) {
+  primask = 1;
+}
+
+int save_interrupt_state_and_disable( void ) {
+  int state = primask;
+
+  primask = 1;
+  return state;
+}
+
+void restore_interrupt_state( int state ) {
+  primask = state;
+  if ( !state ) {
+    host_poll();
+  }
+}
+
+void breakpoint( void ) {
+  fflush( stdout );
+  fprintf( stderr, "[host] breakpoint at %u ticks\n", ticks );
+  exit( 1 );
+}
+
+void wait_for_interrupt( void ) {
+  if ( !tick_period && !compare_armed && !pendsv_pending ) {
+    fflush( stdout );
+    fprintf( stderr, "[host] wait_for_interrupt with no interrupt source\n" );
+    exit( 1 );
+  }
+  host_skip_to_next_event();
+  host_poll();
+}
+
+void pend_pendsv( void ) {
+  pendsv_pending = 1;
+}
+
+void clear_pendsv( void ) {
+  pendsv_pending = 0;
+}
+
+int get_svc_status( void ) {
+  return svc_active;
+}
+
+void set_svc_status( int status ) {
+  svc_active = status;
+}
+
+void enter_user_mode( void ) {
+  boot_time_mark( BOOT_MARK_USER_ENTRY );
+  host_run_user();
+}
+
+int kernel_main( void );
+
+int main( int argc, char **argv ) {
+  static char fault_stack[ HOST_FAULT_STACK_SIZE ];
+  struct sigaction action = { .sa_handler = host_alarm };
+  struct sigaction fault_action = { .sa_handler = host_fault,
+                                    .sa_flags = SA_ONSTACK };
+  stack_t fault_stack_desc = { .ss_sp = fault_stack,
+                               .ss_size = sizeof( fault_stack ) };
+  struct itimerval alarm_period = {
+    .it_interval = { 0, HOST_ALARM_US },
+    .it_value = { 0, HOST_ALARM_US }
+  };
+  const char *limit = getenv( HOST_MAX_TICKS_ENV );
+
+  host_argc = argc;
+  host_argv = argv;
+  max_ticks = limit ? strtoul( limit, NULL, 0 ) : 0;
+
+  sigemptyset( &action.sa_mask );
+  action.sa_flags = SA_RESTART;
+  sigaction( SIGALRM, &action, NULL );
+
+  sigaltstack( &fault_stack_desc, NULL );
+  sigemptyset( &fault_action.sa_mask );
+  sigaction( SIGSEGV, &fault_action, NULL );
+  sigaction( SIGBUS, &fault_action, NULL );
+  sigaction( SIGILL, &fault_action, NULL );
+  sigaction( SIGFPE, &fault_action, NULL );
+  setitimer( ITIMER_REAL, &alarm_period, NULL );
+
+  boot_time_mark( BOOT_MARK_DATA_BSS );
+  return kernel_main();
+}
@@ -0,0 +1,415 @@
+/** @file   host_user.c
+ *
+ *  @brief  User side of the host simulator: the system call stubs from
+ *          svc_stubs.S as direct calls into the kernel, and the glibc
+ *          wrappers host_user.h redirects user programs to.
+ *
+ *          glibc is not reentrant across simulated threads, so every wrapper
+ *          runs it with the tick signal blocked and never makes a system call
+ *          while glibc holds a lock.
+ */
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <host_sim.h>
+#include <syscall.h>
+#include <syscall_mutex.h>
+#include <syscall_sync.h>
+#include <syscall_thread.h>
+#include <syscall_timer.h>
+#include <svc_batch.h>
+#include <svc_num.h>
+
+/** @brief      Largest single printf() output. */
+#define HOST_PRINTF_MAX 1024
+
+/** @brief      The user program's main(), renamed by the Makefile. */
+int user_main( int argc, char **argv );
+
+/**
+ * @brief      Blocks and restores the tick signal around glibc calls.
+ */
+//@{
+static void host_lock( sigset_t *old ) {
+  sigset_t block;
+
+  sigemptyset( &block );
+  sigaddset( &block, SIGALRM );
+  sigprocmask( SIG_BLOCK, &block, old );
+}
+
+static void host_unlock( sigset_t *old ) {
+  sigprocmask( SIG_SETMASK, old, NULL );
+}
+//@}
+
+int thread_init( uint32_t max_threads, uint32_t stack_size, void *idle_fn,
+                 protection_mode memory_protection, uint32_t max_mutexes ) {
+  host_syscall_enter();
+  int result = sys_thread_init( max_threads, stack_size, idle_fn,
+                                memory_protection, max_mutexes );
+  host_syscall_exit();
+  return result;
+}
+
+int thread_create( void *fn, uint32_t prio, uint32_t C, uint32_t T,
+                   void *vargp ) {
+  host_syscall_enter();
+  int result = sys_thread_create( fn, prio, C, T, vargp );
+  host_syscall_exit();
+  return result;
+}
+
+int scheduler_start( uint32_t frequency ) {
+  host_syscall_enter();
+  int result = sys_scheduler_start( frequency );
+  host_syscall_exit();
+  return result;
+}
+
+void wait_until_next_period( void ) {
+  host_syscall_enter();
+  sys_wait_until_next_period();
+  host_syscall_exit();
+}
+
+void thread_kill( void ) {
+  host_syscall_enter();
+  sys_thread_kill();
+  host_syscall_exit();
+}
+
+kmutex_t *mutex_init( uint32_t max_prio ) {
+  host_syscall_enter();
+  kmutex_t *result = sys_mutex_init( max_prio );
+  host_syscall_exit();
+  return result;
+}
+
+void mutex_lock( kmutex_t *mutex ) {
+  host_syscall_enter();
+  sys_mutex_lock( mutex );
+  host_syscall_exit();
+}
+
+void mutex_unlock( kmutex_t *mutex ) {
+  host_syscall_enter();
+  sys_mutex_unlock( mutex );
+  host_syscall_exit();
+}
+
+int mutex_stats( kmutex_t *mutex, mutex_stats_t *stats, int reset ) {
+  host_syscall_enter();
+  int result = sys_mutex_stats( mutex, stats, reset );
+  host_syscall_exit();
+  return result;
+}
+
+int thread_block_stats( uint32_t prio, thread_block_stats_t *stats, int reset ) {
+  host_syscall_enter();
+  int result = sys_thread_block_stats( prio, stats, reset );
+  host_syscall_exit();
+  return result;
+}
+
+int cpu_stats( cpu_stats_t *stats ) {
+  host_syscall_enter();
+  int result = sys_cpu_stats( stats );
+  host_syscall_exit();
+  return result;
+}
+
+int futex_wait( volatile uint32_t *addr, uint32_t expected ) {
+  host_syscall_enter();
+  int result = sys_futex_wait( ( uint32_t * )addr, expected );
+  host_syscall_exit();
+  return result;
+}
+
+void futex_wake( volatile uint32_t *addr ) {
+  host_syscall_enter();
+  sys_futex_wake( ( uint32_t * )addr );
+  host_syscall_exit();
+}
+
+ksem_t *semaphore_init( uint32_t count ) {
+  host_syscall_enter();
+  ksem_t *result = sys_sem_init( count );
+  host_syscall_exit();
+  return result;
+}
+
+int semaphore_wait( ksem_t *sem, uint32_t timeout ) {
+  host_syscall_enter();
+  int result = sys_sem_wait( sem, timeout );
+  host_syscall_exit();
+  return result;
+}
+
+void semaphore_post( ksem_t *sem ) {
+  host_syscall_enter();
+  sys_sem_post( sem );
+  host_syscall_exit();
+}
+
+kevent_t *event_group_init( void ) {
+  host_syscall_enter();
+  kevent_t *result = sys_event_init();
+  host_syscall_exit();
+  return result;
+}
+
+uint32_t event_group_wait( kevent_t *event, uint32_t mask, uint32_t options,
+                           uint32_t timeout ) {
+  host_syscall_enter();
+  uint32_t result = sys_event_wait( event, mask, options, timeout );
+  host_syscall_exit();
+  return result;
+}
+
+void event_group_set( kevent_t *event, uint32_t flags ) {
+  host_syscall_enter();
+  sys_event_set( event, flags );
+  host_syscall_exit();
+}
+
+void event_group_clear( kevent_t *event, uint32_t flags ) {
+  host_syscall_enter();
+  sys_event_clear( event, flags );
+  host_syscall_exit();
+}
+
+kqueue_t *msg_queue_init( uint32_t msg_size, uint32_t capacity ) {
+  host_syscall_enter();
+  kqueue_t *result = sys_queue_init( msg_size, capacity );
+  host_syscall_exit();
+  return result;
+}
+
+int msg_queue_send( kqueue_t *queue, const void *msg, uint32_t timeout ) {
+  host_syscall_enter();
+  int result = sys_queue_send( queue, msg, timeout );
+  host_syscall_exit();
+  return result;
+}
+
+int msg_queue_recv( kqueue_t *queue, void *msg, uint32_t timeout ) {
+  host_syscall_enter();
+  int result = sys_queue_recv( queue, msg, timeout );
+  host_syscall_exit();
+  return result;
+}
+
+ktimer_t *sw_timer_create( void ( *callback )( void * ), void *arg ) {
+  host_syscall_enter();
+  ktimer_t *result = sys_timer_create( ( void * )callback, arg );
+  host_syscall_exit();
+  return result;
+}
+
+int sw_timer_start( ktimer_t *timer, uint32_t delay, uint32_t period ) {
+  host_syscall_enter();
+  int result = sys_timer_start( timer, delay, period );
+  host_syscall_exit();
+  return result;
+}
+
+int sw_timer_stop( ktimer_t *timer ) {
+  host_syscall_enter();
+  int result = sys_timer_stop( timer );
+  host_syscall_exit();
+  return result;
+}
+
+void *sw_timer_wait( void **arg ) {
+  host_syscall_enter();
+  void *result = sys_timer_wait( arg );
+  host_syscall_exit();
+  return result;
+}
+
+void sleep_till_interrupt( void ) {
+  host_syscall_enter();
+  sys_sleep_till_interrupt();
+  host_syscall_exit();
+}
+
+uint32_t get_cycles( void ) {
+  host_syscall_enter();
+  uint32_t result = sys_get_cycles();
+  host_syscall_exit();
+  return result;
+}
+
+uint32_t get_time_us( void ) {
+  host_syscall_enter();
+  uint32_t result = sys_get_time_us();
+  host_syscall_exit();
+  return result;
+}
+
+/**
+ * @brief      One batched call. The kernel's dispatch table passes pointers as
+ *             32-bit words, which does not fit the host, so the calls a user
+ *             program can batch are dispatched here instead.
+ */
+static uintptr_t host_batch_call( svc_sqe_t *sqe ) {
+  uintptr_t *a = sqe->args;
+
+  switch ( sqe->svc_num ) {
+    case SVC_WRITE:
+      return sys_write( ( int )a[ 0 ], ( char * )a[ 1 ], ( int )a[ 2 ] );
+    case SVC_READ:
+      return sys_read( ( int )a[ 0 ], ( char * )a[ 1 ], ( int )a[ 2 ] );
+    case SVC_THR_CREATE:
+      return sys_thread_create( ( void * )a[ 0 ], a[ 1 ], a[ 2 ], a[ 3 ],
+                                ( void * )a[ 4 ] );
+    case SVC_GET_PID:
+      return sys_get_pid();
+    case SVC_MUT_LOK:
+      sys_mutex_lock( ( kmutex_t * )a[ 0 ] );
+      return 0;
+    case SVC_MUT_ULK:
+      sys_mutex_unlock( ( kmutex_t * )a[ 0 ] );
+      return 0;
+    case SVC_WAIT:
+      sys_wait_until_next_period();
+      return 0;
+    case SVC_TIME:
+      return sys_get_time();
+    case SVC_PRIORITY:
+      return sys_get_priority();
+    case SVC_THR_TIME:
+      return sys_thread_time();
+    case SVC_OS_GET_TICKS:
+      return sys_os_get_ticks();
+    case SVC_GET_CYCLES:
+      return sys_get_cycles();
+    case SVC_SLEEP_TILL_INT:
+      sys_sleep_till_interrupt();
+      return 0;
+    case SVC_GET_TIME_US:
+      return sys_get_time_us();
+    default:
+      return SVC_BATCH_EINVAL;
+  }
+}
+
+int batch_submit( svc_batch_t *batch ) {
+  uint32_t count = batch->count < SVC_BATCH_MAX ? batch->count : SVC_BATCH_MAX;
+
+  host_syscall_enter();
+  for ( uint32_t i = 0; i < count; i++ ) {
+    batch->cq[ i ] = host_batch_call( &batch->sq[ i ] );
+  }
+  host_syscall_exit();
+  return count;
+}
+
+int svc_stats_dump( int reset ) {
+  // Host system calls bypass the SVC dispatcher, so there is nothing to dump.
+  ( void )reset;
+  return -1;
+}
+
+int irq_latency_dump( int reset ) {
+  // Virtual time takes every interrupt on time, so there is nothing to sample.
+  ( void )reset;
+  return -1;
+}
+
+ssize_t host_write( int file, const void *ptr, size_t len ) {
+  host_syscall_enter();
+  int result = sys_write( file, ( char * )ptr, ( int )len );
+  host_syscall_exit();
+  return result;
+}
+
+ssize_t host_read( int file, void *ptr, size_t len ) {
+  host_syscall_enter();
+  int result = sys_read( file, ptr, ( int )len );
+  host_syscall_exit();
+  return result;
+}
+
+void host_exit( int status ) {
+  host_syscall_enter();
+  sys_exit( status );
+  host_syscall_exit();
+  fflush( stdout );
+  exit( status );
+}
+
+int host_printf( const char *fmt, ... ) {
+  char buffer[ HOST_PRINTF_MAX ];
+  sigset_t old;
+  va_list args;
+  int len;
+
+  host_lock( &old );
+  va_start( args, fmt );
+  len = vsnprintf( buffer, sizeof( buffer ), fmt, args );
+  va_end( args );
+  host_unlock( &old );
+
+  if ( len > ( int )sizeof( buffer ) - 1 ) {
+    len = sizeof( buffer ) - 1;
+  }
+  return len > 0 ? host_write( 1, buffer, len ) : len;
+}
+
+int host_putchar( int c ) {
+  char byte = ( char )c;
+
+  host_write( 1, &byte, 1 );
+  return ( unsigned char )c;
+}
+
+int host_puts( const char *s ) {
+  host_write( 1, s, strlen( s ) );
+  host_write( 1, "\n", 1 );
+  return 0;
+}
+
+void *host_malloc( size_t size ) {
+  sigset_t old;
+
+  host_lock( &old );
+  void *result = malloc( size );
+  host_unlock( &old );
+  return result;
+}
+
+void *host_calloc( size_t count, size_t size ) {
+  sigset_t old;
+
+  host_lock( &old );
+  void *result = calloc( count, size );
+  host_unlock( &old );
+  return result;
+}
+
+void *host_realloc( void *ptr, size_t size ) {
+  sigset_t old;
+
+  host_lock( &old );
+  void *result = realloc( ptr, size );
+  host_unlock( &old );
+  return result;
+}
+
+void host_free( void *ptr ) {
+  sigset_t old;
+
+  host_lock( &old );
+  free( ptr );
+  host_unlock( &old );
+}
+
+void host_run_user( void ) {
+  host_exit( user_main( host_argc, host_argv ) );
+}
@@ -11,40 +11,22 @@
 
 #define intrinsic __attribute__( ( always_inline ) ) static inline
 
+/**
+ * @brief      Places a function in the .ramfunc section, which _reset_ copies
+ *             to SRAM, so it executes without flash wait states. Use for hot
+ *             handlers. Calls out to flash go through linker veneers, and
+ *             long_call lets flash code call back in.
+ */
+#define RAMFUNC __attribute__( ( section( ".ramfunc" ), long_call, noinline ) )
+
 #include <unistd.h>
+#include <stdint.h>
 
 void init_349( void );
 
 void enable_fpu( void );
 
-/**
- * @brief      Asm wrapper for strex.
- *
- * @param      addr  Address to which you want to store exclusively.
- * @param[in]  val   TCalue to store to address.
- *
- * @return     Return 1 if successful else return 0.
- */
-intrinsic uint32_t store_exclusive_register( uint32_t *addr, uint32_t val ) {
-  uint32_t result;
-
-  __asm volatile ( "strex %0, %1, [%2]" : "=r" ( result ) : "r" ( val ), "r" ( addr ) );
-  return( result );
-}
-
-/**
- * @brief      Loads an exclusive register.
- *
- * @param      addr  The address
- *
- * @return     { description_of_the_return_value }
- */
-intrinsic uint32_t load_exclusive_register( uint32_t *addr ) {
-  uint32_t result;
-
-  __asm volatile ( "ldrex %0, [%1]" : "=r" ( result ) : "r" ( addr ) );
-  return( result );
-}
+#include "exclusive.h"
 
 /**
  * @brief      Enables the interrupts.
@@ -68,7 +50,7 @@ intrinsic int save_interrupt_state_and_disable( void ) {
   int result;
   int disable_constant = 1;
   __asm volatile( "mrs %0, PRIMASK"  : "=r" ( result ));
-  __asm volatile( "msr PRIMASK, %0" : "=r" (disable_constant));
+  __asm volatile( "msr PRIMASK, %0" : : "r" ( disable_constant ) : "memory" );
   return result;
 }
 
@@ -77,7 +59,7 @@ intrinsic int save_interrupt_state_and_disable( void ) {
  *             disables interrupts.
  */
 intrinsic void restore_interrupt_state( int state ) {
-  __asm volatile( "msr PRIMASK, %0" : "=r" ( state ) );
+  __asm volatile( "msr PRIMASK, %0" : : "r" ( state ) : "memory" );
 }
 
 /**
@@ -0,0 +1,52 @@
+/** @file boot_time.h
+ *
+ *  @brief  Boot phase timestamps taken with the DWT cycle counter.
+ *
+ *          Each mark is the cycle count at the end of a boot phase, so the
+ *          cost of a phase is the difference to the previous mark. Marks
+ *          for phases that run before C (data/bss copy) or at the hand-off to
+ *          user code are written from assembly, which indexes boot_marks
+ *          directly; keep the order below in sync with boot.S and
+ *          asm_helpers.S.
+ */
+#ifndef _BOOT_TIME_H_
+#define _BOOT_TIME_H_
+
+#include <dwt.h>
+
+/**
+ * @enum boot_mark
+ *
+ * @brief      Boot phases, in the order they complete.
+ */
+typedef enum {
+  BOOT_MARK_DATA_BSS = 0,   /**< .data copied and .bss cleared (boot.S) */
+  BOOT_MARK_INIT_349 = 1,   /**< init_349 done */
+  BOOT_MARK_CLOCK = 2,      /**< clock_init done */
+  BOOT_MARK_UART = 3,       /**< uart_init done */
+  BOOT_MARK_TIMER = 4,      /**< timer_start done */
+  BOOT_MARK_USER_ENTRY = 5, /**< Branching to _crt0 (asm_helpers.S) */
+  BOOT_MARK_COUNT
+} boot_mark;
+
+/** @brief Cycle count at the end of each boot phase. */
+extern uint32_t boot_marks[ BOOT_MARK_COUNT ];
+
+/**
+ * @brief      Records the end of a boot phase.
+ *
+ * @param[in]  mark  The phase that just completed.
+ */
+static inline void boot_time_mark( boot_mark mark ) {
+  boot_marks[ mark ] = dwt_get_cycles();
+}
+
+/**
+ * @brief      Prints the per-phase cycle costs over printk, flagging any phase
+ *             that went over its budget. Kernels built with BOOT_TIME=1 call
+ *             it from the first scheduler_start(); otherwise read the marks
+ *             with the boot_time gdb macro.
+ */
+void boot_time_report( void );
+
+#endif /* _BOOT_TIME_H_ */
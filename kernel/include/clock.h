@@ -0,0 +1,51 @@
+/** @file clock.h
+ *
+ *  @brief  System clock tree configuration.
+ *
+ *          clock_init() runs the PLL off the 16 MHz HSI, programs the flash
+ *          wait states and enables the ART accelerator (prefetch, I-cache and
+ *          D-cache). Drivers that derive divisors from a bus clock (SysTick,
+ *          UART) must read it through the getters below instead of assuming
+ *          a frequency. Until clock_init() succeeds, every clock reads as the
+ *          HSI frequency the part resets to.
+ */
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+#include <unistd.h>
+
+/** @brief Frequency of the internal oscillator the part boots from. */
+#define CLOCK_HSI_HZ 16000000
+/** @brief Highest SYSCLK the STM32F401 supports. */
+#define CLOCK_SYSCLK_MAX_HZ 84000000
+/** @brief Highest APB1 clock the STM32F401 supports. */
+#define CLOCK_PCLK1_MAX_HZ 42000000
+
+/**
+ * @brief      Configures the PLL for the requested SYSCLK and switches to it.
+ *
+ *             AHB runs at SYSCLK, APB2 at SYSCLK and APB1 at the fastest
+ *             power-of-two division of SYSCLK within CLOCK_PCLK1_MAX_HZ.
+ *
+ * @param[in]  sysclk_hz  Requested SYSCLK. Must be a whole number of MHz, at
+ *                        most CLOCK_SYSCLK_MAX_HZ, and reachable by the PLL
+ *                        from a 1 MHz VCO input.
+ *
+ * @return     0 on success, -1 if the frequency cannot be produced (the clock
+ *             tree is left untouched in that case).
+ */
+int clock_init( uint32_t sysclk_hz );
+
+/** @brief Returns the current SYSCLK frequency in Hz. */
+uint32_t clock_get_sysclk_hz( void );
+
+/** @brief Returns the current AHB (core, SysTick) frequency in Hz. */
+uint32_t clock_get_hclk_hz( void );
+
+/** @brief Returns the current APB1 peripheral clock in Hz. */
+uint32_t clock_get_pclk1_hz( void );
+
+/** @brief Returns the current APB2 peripheral clock in Hz. */
+uint32_t clock_get_pclk2_hz( void );
+
+#endif /* _CLOCK_H_ */
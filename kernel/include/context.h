@@ -0,0 +1,51 @@
+/** @file context.h
+ *
+ *  @brief  Target interface for creating thread contexts.
+ *
+ *          A context is an opaque pointer the scheduler hands back and forth
+ *          with the PendSV handler: pendsv_c_handler() receives the context of
+ *          the thread being switched out and returns the one to resume. On the
+ *          Cortex-M4 it is the saved kernel stack pointer (see _pend_sv_ in
+ *          boot.S); the host simulator (kernel/host) uses its own
+ *          representation.
+ */
+#ifndef _CONTEXT_H_
+#define _CONTEXT_H_
+
+#include <stdint.h>
+
+/**
+ * @brief      Kernel stack a context built by context_init() takes right below
+ *             kstack_top, the frame _pend_sv_ pushes.
+ */
+#define CONTEXT_KSTACK_BYTES 40
+
+/**
+ * @brief      Builds the initial context of a thread so that the first switch
+ *             to it starts running fn( vargp ) in unprivileged thread mode.
+ *
+ * @param[in]  kstack_top  One past the top of the thread's kernel stack.
+ * @param[in]  ustack_top  One past the top of the thread's user stack.
+ * @param[in]  fn          Thread function.
+ * @param[in]  vargp       Argument for fn.
+ * @param[in]  exit_fn     Function fn returns into.
+ *
+ * @return     The context to hand to the PendSV handler.
+ */
+void *context_init( void *kstack_top,
+                    void *ustack_top,
+                    void *fn,
+                    void *vargp,
+                    void *exit_fn );
+
+/**
+ * @brief      Where a switched-out context's stacks end, so another context can
+ *             be built right below it on the same stacks.
+ *
+ * @param[in]  context     The context.
+ * @param[out] kstack_top  Lowest address in use on its kernel stack.
+ * @param[out] ustack_top  Lowest address in use on its user stack.
+ */
+void context_stack_limits( void *context, void **kstack_top, void **ustack_top );
+
+#endif /* _CONTEXT_H_ */
@@ -0,0 +1,52 @@
+/** @file   cpu_stats.h
+ *
+ *  @brief  CPU utilisation over a sliding window, shared by the kernel and
+ *          user programs.
+ *
+ *          The kernel splits time into buckets of CPU_STATS_BUCKET_US and
+ *          keeps the last CPU_STATS_BUCKETS complete ones, so a snapshot
+ *          covers about a second that slides forward every quarter second.
+ *          Time in interrupt handlers (SysTick, PendSV, the release timer
+ *          and the UART) is counted apart and left out of every thread's
+ *          time, so the thread times, idle and handler times add up to the
+ *          window. System calls count as their caller's time.
+ */
+
+#ifndef _CPU_STATS_H_
+#define _CPU_STATS_H_
+
+#include <stdint.h>
+
+/** @brief      Length of each bucket in microseconds, rounded up to a tick. */
+#define CPU_STATS_BUCKET_US 250000
+
+/** @brief      Complete buckets a snapshot sums. */
+#define CPU_STATS_BUCKETS 4
+
+/** @brief      Threads reported, one per priority as in thread_create(). */
+#define CPU_STATS_THREADS 32
+
+/**
+ * @brief      One thread's share of the window.
+ */
+typedef struct {
+  uint32_t run_us;   /**< Time it ran */
+  uint32_t switches; /**< Times it was switched in */
+  uint32_t C;        /**< Budget given to thread_create(), 0 if no thread */
+  uint32_t T;        /**< Period given to thread_create() */
+} cpu_thread_stats_t;
+
+/**
+ * @brief      A snapshot of the window.
+ */
+typedef struct {
+  uint32_t window_us; /**< Time the snapshot covers */
+  uint32_t tick_us;   /**< Length of a tick, to turn C and T into time */
+  uint32_t idle_us;   /**< Time in the idle thread */
+  uint32_t main_us;   /**< Time in the main thread */
+  uint32_t isr_us;    /**< Time in interrupt handlers */
+  uint32_t switches;  /**< Context switches */
+  cpu_thread_stats_t threads[ CPU_STATS_THREADS ];
+} cpu_stats_t;
+
+#endif /* _CPU_STATS_H_ */
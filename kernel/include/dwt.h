@@ -0,0 +1,41 @@
+/** @file dwt.h
+ *
+ *  @brief  Access to the DWT cycle counter.
+ *
+ *          The counter is enabled and zeroed by _reset_ in boot.S, so
+ *          dwt_get_cycles() returns core clock cycles since reset (modulo
+ *          2^32). The DWT lives on the private peripheral bus and can only be
+ *          read from privileged code.
+ */
+#ifndef _DWT_H_
+#define _DWT_H_
+
+#define intrinsic __attribute__( ( always_inline ) ) static inline
+
+#include <unistd.h>
+
+/** @brief Debug exception and monitor control register and flags */
+//@{
+#define DEMCR ( ( volatile uint32_t * ) 0xE000EDFC )
+#define DEMCR_TRCENA ( 1 << 24 )
+//@}
+/** @brief DWT control register and flags */
+//@{
+#define DWT_CTRL ( ( volatile uint32_t * ) 0xE0001000 )
+#define DWT_CTRL_CYCCNTENA ( 1 << 0 )
+//@}
+/** @brief DWT cycle count register */
+#define DWT_CYCCNT ( ( volatile uint32_t * ) 0xE0001004 )
+
+/**
+ * @brief      Reads the DWT cycle counter.
+ *
+ * @return     Core clock cycles since reset.
+ */
+intrinsic uint32_t dwt_get_cycles( void ) {
+  return *DWT_CYCCNT;
+}
+
+#undef intrinsic
+
+#endif /* _DWT_H_ */
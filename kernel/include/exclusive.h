@@ -0,0 +1,53 @@
+/** @file exclusive.h
+ *
+ *  @brief  Asm wrappers for ldrex, strex and clrex, split from arm.h so user
+ *          code can build lock-free structures on them without the rest of it.
+ *          Each is also a compiler barrier, so memory accesses are not moved
+ *          across them.
+ */
+#ifndef _EXCLUSIVE_H_
+#define _EXCLUSIVE_H_
+
+#include <stdint.h>
+
+/**
+ * @brief      Asm wrapper for strex.
+ *
+ * @param      addr  Address to which you want to store exclusively.
+ * @param[in]  val   Value to store to address.
+ *
+ * @return     Return 0 if successful else return 1.
+ */
+__attribute__( ( always_inline ) ) static inline
+uint32_t store_exclusive_register( uint32_t *addr, uint32_t val ) {
+  uint32_t result;
+
+  __asm volatile ( "strex %0, %1, [%2]" : "=r" ( result ) : "r" ( val ), "r" ( addr ) : "memory" );
+  return( result );
+}
+
+/**
+ * @brief      Loads an exclusive register.
+ *
+ * @param      addr  The address
+ *
+ * @return     The value at addr.
+ */
+__attribute__( ( always_inline ) ) static inline
+uint32_t load_exclusive_register( uint32_t *addr ) {
+  uint32_t result;
+
+  __asm volatile ( "ldrex %0, [%1]" : "=r" ( result ) : "r" ( addr ) : "memory" );
+  return( result );
+}
+
+/**
+ * @brief      Asm wrapper for clrex, which gives up the reservation of a
+ *             load_exclusive_register() that will not be followed by a store.
+ */
+__attribute__( ( always_inline ) ) static inline
+void clear_exclusive( void ) {
+  __asm volatile ( "clrex" : : : "memory" );
+}
+
+#endif /* _EXCLUSIVE_H_ */
@@ -0,0 +1,75 @@
+/** @file fault.h
+ *
+ *  @brief  Fault handlers and the crash log.
+ *
+ *          HardFault, MemManage, BusFault and UsageFault all end up in
+ *          fault_c_handler(), which saves a crash record and then recovers
+ *          if it can. A fault in a user thread kills just that thread, as if
+ *          it had called thread_kill() (see sys_thread_kill() for its
+ *          mutexes), and the scheduler carries on. A fault in a handler or in
+ *          the idle or main thread leaves nothing safe to return to, so the
+ *          board resets, or stops at a breakpoint when a debugger is attached.
+ *
+ *          The log lives in .noinit, which _reset_ neither loads nor clears,
+ *          so records of the faults before a reset are still there for
+ *          fault_report() at the next boot. A power cycle loses them.
+ */
+#ifndef _FAULT_H_
+#define _FAULT_H_
+
+#include <stdint.h>
+
+/** @brief Records kept, the oldest is overwritten first. */
+#define FAULT_RECORDS 4
+
+/** @brief Thread ID recorded for a fault in handler mode. */
+#define FAULT_NO_THREAD 0xFF
+
+/**
+ * @enum fault_type
+ *
+ * @brief      Which exception took the fault. Numbered as in boot.S.
+ */
+typedef enum {
+  FAULT_HARD = 0,
+  FAULT_MM = 1,
+  FAULT_BUS = 2,
+  FAULT_USAGE = 3
+} fault_type;
+
+/**
+ * @struct fault_record_t
+ *
+ * @brief      One fault.
+ */
+typedef struct {
+  uint32_t seq;        /**< Faults recorded before this one, since power up */
+  uint8_t type;        /**< fault_type */
+  uint8_t thread;      /**< Thread ID, idle 32, main 33 or FAULT_NO_THREAD */
+  uint8_t killed;      /**< Whether only the thread was killed */
+  uint8_t frame_valid; /**< Whether frame could be read */
+  uint32_t reported;   /**< Whether it has been printed */
+  uint32_t cfsr;       /**< Configurable fault status */
+  uint32_t hfsr;       /**< HardFault status */
+  uint32_t mmfar;      /**< MemManage address, if CFSR.MMARVALID */
+  uint32_t bfar;       /**< BusFault address, if CFSR.BFARVALID */
+  uint32_t exc_return; /**< lr on exception entry */
+  uint32_t frame[ 8 ]; /**< Stacked r0-r3, r12, lr, pc and xPSR */
+} fault_record_t;
+
+/**
+ * @brief      Prints the records not printed yet, those of a fault that
+ *             reset the board. Called at boot.
+ */
+void fault_report( void );
+
+/**
+ * @brief      Common fault handler, entered from the stubs in boot.S.
+ *
+ * @param[in]  frame       The exception frame, on whichever stack was active.
+ * @param[in]  type        A fault_type.
+ * @param[in]  exc_return  lr on exception entry.
+ */
+void fault_c_handler( uint32_t *frame, uint32_t type, uint32_t exc_return );
+
+#endif /* _FAULT_H_ */
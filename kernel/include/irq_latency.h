@@ -0,0 +1,110 @@
+/** @file irq_latency.h
+ *
+ *  @brief  SysTick interrupt latency samples.
+ *
+ *          Built only with IRQ_LATENCY=1, which defines IRQ_LATENCY. Otherwise
+ *          the hook below is empty and irq_latency_dump() returns -1. The SysTick
+ *          entry stub in boot.S reads VAL first thing, so a sample is the core
+ *          cycles from VAL reaching 0, which pends the tick, to that read:
+ *          exception entry plus whatever held the interrupt back, a PRIMASK
+ *          critical section or a handler of the same or higher priority. A
+ *          tick held back past the next one reads as the remainder, and the tick after a tickless sleep
+ *          that ran its whole window is not sampled, since the counter has
+ *          been reprogrammed by then.
+ *
+ *          Each sample is put against the running thread, and the worst ones
+ *          keep the pc they interrupted. A pc inside a kernel function whose
+ *          sample was taken in handler mode names the critical section that
+ *          ended just before, since the tick is taken as soon as PRIMASK
+ *          clears. A tick held back by PendSV or the release timer is taken
+ *          as that handler returns, against the thread it returns to.
+ *
+ *          Bucket b counts samples of [ 2^(b-1), 2^b ) cycles, bucket 0
+ *          samples of none and the last bucket everything longer. Dump them
+ *          with irq_latency_dump() from user code or irq_latency in gdb.
+ */
+#ifndef _IRQ_LATENCY_H_
+#define _IRQ_LATENCY_H_
+
+#include <stdint.h>
+
+/** @brief Histogram buckets, the last one from 2^14 cycles up. */
+#define IRQ_LATENCY_BUCKETS 16
+
+/** @brief Worst samples kept, with the pc they interrupted. */
+#define IRQ_LATENCY_WORST 8
+
+/** @brief Threads samples are put against: one per priority, idle and main. */
+#define IRQ_LATENCY_THREADS 34
+
+/**
+ * @struct irq_latency_sample_t
+ *
+ * @brief  One sample.
+ */
+typedef struct {
+  uint32_t cycles;  /**< Cycles from VAL reaching 0 to the handler */
+  uint32_t pc;      /**< pc it interrupted */
+  uint8_t thread;   /**< Running thread, idle 32 and main 33 */
+  uint8_t handler;  /**< Whether it interrupted handler mode */
+} irq_latency_sample_t;
+
+/**
+ * @struct irq_latency_thread_t
+ *
+ * @brief  Samples taken while one thread was running.
+ */
+typedef struct {
+  uint32_t count;   /**< Samples */
+  uint64_t cycles;  /**< Sum of their latencies */
+  uint32_t max;     /**< Longest one */
+} irq_latency_thread_t;
+
+/**
+ * @struct irq_latency_t
+ *
+ * @brief  Every sample since the last reset.
+ */
+typedef struct {
+  uint32_t count;                                  /**< Samples */
+  uint64_t cycles;                                 /**< Sum of their latencies */
+  uint32_t min;                                    /**< Shortest one */
+  uint32_t max;                                    /**< Longest one */
+  uint32_t buckets[ IRQ_LATENCY_BUCKETS ];         /**< log2 histogram */
+  irq_latency_thread_t threads[ IRQ_LATENCY_THREADS ];
+  irq_latency_sample_t worst[ IRQ_LATENCY_WORST ]; /**< Longest first */
+} irq_latency_t;
+
+#ifdef IRQ_LATENCY
+
+/** @brief The samples. */
+extern irq_latency_t irq_latency;
+
+/**
+ * @brief      Adds a sample. Called from the SysTick handler only.
+ *
+ * @param[in]  cycles      Cycles from VAL reaching 0 to the handler.
+ * @param[in]  frame       The exception frame.
+ * @param[in]  exc_return  lr on exception entry.
+ */
+void irq_latency_record( uint32_t cycles, uint32_t *frame, uint32_t exc_return );
+
+#else
+
+static inline void irq_latency_record( uint32_t cycles, uint32_t *frame,
+                                       uint32_t exc_return ) {
+  ( void )cycles; ( void )frame; ( void )exc_return;
+}
+
+#endif /* IRQ_LATENCY */
+
+/**
+ * @brief      Prints the samples taken so far.
+ *
+ * @param[in]  reset  Clears them after printing when non-zero.
+ *
+ * @return     0, or -1 if the kernel was built without IRQ_LATENCY.
+ */
+int sys_irq_latency_dump( int reset );
+
+#endif /* _IRQ_LATENCY_H_ */
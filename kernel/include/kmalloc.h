@@ -29,7 +29,11 @@ typedef struct list_node{
  */
 typedef struct kmalloc_t {
   list_node* free_node;
-  /* You might want to add some other things here */
+  char* heap_low;      /**< Lowest address of the heap */
+  char* heap_top;      /**< One past the highest address of the heap */
+  char* brk;           /**< Next unallocated address */
+  uint32_t stack_size; /**< Size of every aligned allocation, in bytes */
+  uint32_t unaligned;  /**< Whether unaligned allocations are allowed */
 }kmalloc_t;
 
 void k_malloc_init( kmalloc_t* internals,
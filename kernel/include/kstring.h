@@ -0,0 +1,60 @@
+/** @file kstring.h
+ *
+ *  @brief  Memory clear and copy for the kernel.
+ *
+ *          The kernel is linked -nostdlib, so it cannot call memset and
+ *          memcpy without pulling them out of the user C library. Kernel
+ *          sources are also built with -fno-tree-loop-distribute-patterns so
+ *          that GCC does not turn these loops back into those calls. Large
+ *          structs are cleared with k_memset rather than assigned, for the
+ *          same reason.
+ */
+#ifndef _KSTRING_H_
+#define _KSTRING_H_
+
+#include <stdint.h>
+
+/**
+ * @brief      Sets len bytes at dst to val, a word at a time when dst and len
+ *             are word aligned.
+ */
+static inline void k_memset( void *dst, uint8_t val, uint32_t len ) {
+  if ( ( ( uintptr_t )dst | len ) % sizeof( uint32_t ) == 0 ) {
+    uint32_t *word = dst;
+    uint32_t fill = val * 0x01010101U;
+
+    for ( uint32_t i = 0; i < len / sizeof( uint32_t ); i++ ) {
+      word[ i ] = fill;
+    }
+  } else {
+    uint8_t *byte = dst;
+
+    for ( uint32_t i = 0; i < len; i++ ) {
+      byte[ i ] = val;
+    }
+  }
+}
+
+/**
+ * @brief      Copies len bytes from src to dst, which must not overlap, a
+ *             word at a time when both and len are word aligned.
+ */
+static inline void k_memcpy( void *dst, const void *src, uint32_t len ) {
+  if ( ( ( uintptr_t )dst | ( uintptr_t )src | len ) % sizeof( uint32_t ) == 0 ) {
+    uint32_t *to = dst;
+    const uint32_t *from = src;
+
+    for ( uint32_t i = 0; i < len / sizeof( uint32_t ); i++ ) {
+      to[ i ] = from[ i ];
+    }
+  } else {
+    uint8_t *to = dst;
+    const uint8_t *from = src;
+
+    for ( uint32_t i = 0; i < len; i++ ) {
+      to[ i ] = from[ i ];
+    }
+  }
+}
+
+#endif /* _KSTRING_H_ */
@@ -0,0 +1,39 @@
+/** @file   lock_stats.h
+ *
+ *  @brief  Mutex and blocking statistics, shared by the kernel and user
+ *          programs. All times are in core cycles from the DWT counter.
+ *
+ *          A thread is blocked while it waits in mutex_lock() or futex_wait(),
+ *          and while it is ready but a lower priority thread runs at a
+ *          ceiling above it. Under the priority ceiling protocol that second
+ *          case is where nearly all blocking happens, and each interval of it
+ *          should stay within the blocking term of the schedulability test.
+ */
+
+#ifndef _LOCK_STATS_H_
+#define _LOCK_STATS_H_
+
+#include <stdint.h>
+
+/**
+ * @brief      Statistics of one mutex.
+ */
+typedef struct {
+  uint32_t acquisitions; /**< Times it was locked */
+  uint32_t contentions;  /**< Locks that had to wait */
+  uint32_t max_hold;     /**< Longest time held */
+  uint64_t total_hold;   /**< Time held, over all acquisitions */
+} mutex_stats_t;
+
+/**
+ * @brief      Blocking statistics of one thread.
+ */
+typedef struct {
+  uint32_t blocked_count; /**< Separate intervals it was blocked for */
+  uint32_t max_blocked;   /**< Longest of them */
+  uint64_t total_blocked; /**< Their sum */
+  int32_t max_mutex;      /**< Mutex at the system ceiling when the longest
+                               began, by mutex_init() order. -1 if none. */
+} thread_block_stats_t;
+
+#endif /* _LOCK_STATS_H_ */
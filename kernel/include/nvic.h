@@ -18,6 +18,10 @@ struct nvic_t {
 #define NVIC_ISER_BASE (struct nvic_t *) 0xE000E100
 #define NVIC_ICER_BASE (struct nvic_t *) 0xE000E180
 #define NVIC_ICPR_BASE (struct nvic_t *) 0xE000E280
+/** @brief Interrupt priority registers, one byte per IRQ */
+#define NVIC_IPR_BASE (volatile uint8_t *) 0xE000E400
+/** @brief Priority bits the STM32F4 implements, the top 4 of each byte */
+#define NVIC_PRIO_SHIFT 4
 #define NVIC_REG_SIZE 32
 #define IRQ_ENABLE 1
 #define IRQ_DISABLE 0
@@ -25,4 +29,10 @@ struct nvic_t {
 void nvic_irq( uint8_t irq_num, uint8_t status );
 void nvic_clear_pending( uint8_t irq_num );
 
+/**
+ * @brief Sets an IRQ's priority, 0 (highest) to 15, in the same numbering as
+ * the system handler priorities init_349() sets.
+ */
+void nvic_set_priority( uint8_t irq_num, uint8_t priority );
+
 #endif //_NVIC_H
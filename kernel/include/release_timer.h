@@ -0,0 +1,62 @@
+/** @file release_timer.h
+ *
+ *  @brief  TIM5 as a free-running 1 MHz timebase with a one-shot compare.
+ *
+ *          TIM5 is one of the F401's two 32-bit timers, so it counts whole
+ *          microseconds for 71 minutes before wrapping, where SysTick's 24-bit
+ *          reload only reaches the next tick. The scheduler keeps thread
+ *          releases on it and arms the compare for the earliest one, so a
+ *          release lands at its own microsecond rather than the tick boundary
+ *          after it.
+ *
+ *          The compare interrupt (IRQ50) runs at the SysTick and PendSV
+ *          priority, so it never preempts the scheduler.
+ */
+#ifndef _RELEASE_TIMER_H_
+#define _RELEASE_TIMER_H_
+
+#include <stdint.h>
+
+/** @brief Counts per second of the timebase. */
+#define RELEASE_TIMER_HZ 1000000
+
+/**
+ * @brief      Restarts the timebase from 0 with the compare disarmed.
+ *
+ * @return     0 on success, -1 if the timer clock is not a whole number of
+ *             MHz, in which case the timer is left stopped.
+ */
+int release_timer_start( void );
+
+/**
+ * @brief      Stops the timebase and disarms the compare.
+ */
+void release_timer_stop( void );
+
+/**
+ * @brief      Reads the timebase.
+ *
+ * @return     Microseconds since release_timer_start(), modulo 2^32.
+ */
+uint32_t release_timer_now( void );
+
+/**
+ * @brief      Arms the one-shot compare. An instant that has already passed
+ *             interrupts at once.
+ *
+ * @param[in]  at    Timebase value to interrupt at.
+ */
+void release_timer_arm( uint32_t at );
+
+/**
+ * @brief      Disarms the compare.
+ */
+void release_timer_cancel( void );
+
+/**
+ * @brief      Compare interrupt, IRQ50. Disarms the compare and hands over to
+ *             sched_release_timer().
+ */
+void release_timer_irq_handler( void );
+
+#endif /* _RELEASE_TIMER_H_ */
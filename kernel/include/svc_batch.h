@@ -0,0 +1,52 @@
+/** @file svc_batch.h
+ *
+ *  @brief  Layout of a batch of system calls submitted with one SVC.
+ *
+ *          A thread queues calls in sq[] and submits them with
+ *          batch_submit(). The kernel runs sq[ 0 ] to sq[ count - 1 ] in order
+ *          from the one exception and stores each return value in the matching
+ *          cq[] slot, as if each call had been made on its own. A call that
+ *          blocks, like wait_until_next_period(), blocks the rest of the batch
+ *          with it. Unknown numbers and nested batches complete with
+ *          SVC_BATCH_EINVAL and do not stop the batch.
+ *
+ *          user_common/include/349_lib.h includes this file, so it must stay
+ *          free of kernel-only declarations.
+ */
+#ifndef _SVC_BATCH_H_
+#define _SVC_BATCH_H_
+
+#include <stdint.h>
+
+/** @brief Most calls in one batch. */
+#define SVC_BATCH_MAX 16
+
+/** @brief Arguments per call, the most any system call takes. */
+#define SVC_BATCH_ARGS 5
+
+/** @brief Completion value of a call the kernel refused to run. */
+#define SVC_BATCH_EINVAL ( ( uintptr_t ) -1 )
+
+/**
+ * @struct svc_sqe_t
+ *
+ * @brief  One queued call: the SVC number from svc_num.h and its arguments.
+ */
+typedef struct {
+  uint32_t svc_num;
+  uintptr_t args[ SVC_BATCH_ARGS ];
+} svc_sqe_t;
+
+/**
+ * @struct svc_batch_t
+ *
+ * @brief  Submission and completion arrays. count is the number of queued
+ *         calls and is left alone by the kernel.
+ */
+typedef struct {
+  uint32_t count;
+  svc_sqe_t sq[ SVC_BATCH_MAX ];
+  uintptr_t cq[ SVC_BATCH_MAX ];
+} svc_batch_t;
+
+#endif /* _SVC_BATCH_H_ */
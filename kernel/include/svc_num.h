@@ -52,8 +52,60 @@
 #define SVC_PRIORITY    19
 /** @brief SVC number for thread_get_time() */
 #define SVC_THR_TIME   20
-/** @brief SVC number for sleep_till_interrupt */
+/** @brief SVC number for sleep_till_interrupt() */
 #define SVC_SLEEP_TILL_INT 21
+/** @brief SVC number for _os_get_ticks() */
+#define SVC_OS_GET_TICKS 22
+/** @brief SVC number for get_cycles() */
+#define SVC_GET_CYCLES 23
+/** @brief SVC number for batch_submit() */
+#define SVC_BATCH 24
+/** @brief SVC number for svc_stats_dump() */
+#define SVC_STATS_DUMP 25
+/** @brief SVC number for futex_wait() */
+#define SVC_FUTEX_WAIT 26
+/** @brief SVC number for futex_wake() */
+#define SVC_FUTEX_WAKE 27
+/** @brief SVC number for semaphore_init() */
+#define SVC_SEM_INIT 28
+/** @brief SVC number for semaphore_wait() */
+#define SVC_SEM_WAIT 29
+/** @brief SVC number for semaphore_post() */
+#define SVC_SEM_POST 30
+/** @brief SVC number for event_group_init() */
+#define SVC_EVENT_INIT 31
+/** @brief SVC number for event_group_wait() */
+#define SVC_EVENT_WAIT 32
+/** @brief SVC number for event_group_set() */
+#define SVC_EVENT_SET 33
+/** @brief SVC number for event_group_clear() */
+#define SVC_EVENT_CLEAR 34
+/** @brief SVC number for msg_queue_init() */
+#define SVC_QUEUE_INIT 35
+/** @brief SVC number for msg_queue_send() */
+#define SVC_QUEUE_SEND 36
+/** @brief SVC number for msg_queue_recv() */
+#define SVC_QUEUE_RECV 37
+/** @brief SVC number for mutex_stats() */
+#define SVC_MUT_STATS 38
+/** @brief SVC number for thread_block_stats() */
+#define SVC_THR_BLOCK_STATS 39
+/** @brief SVC number for get_time_us() */
+#define SVC_GET_TIME_US 40
+/** @brief SVC number for sw_timer_create() */
+#define SVC_TIMER_CREATE 41
+/** @brief SVC number for sw_timer_start() */
+#define SVC_TIMER_START 42
+/** @brief SVC number for sw_timer_stop() */
+#define SVC_TIMER_STOP 43
+/** @brief SVC number for sw_timer_wait() */
+#define SVC_TIMER_WAIT 44
+/** @brief SVC number for cpu_stats() */
+#define SVC_CPU_STATS 45
+/** @brief SVC number for irq_latency_dump() */
+#define SVC_IRQ_LATENCY_DUMP 46
+/** @brief One past the highest SVC number */
+#define SVC_COUNT 47
 
 
 
@@ -0,0 +1,81 @@
+/** @file svc_stats.h
+ *
+ *  @brief  Per-SVC call counts and latency histograms.
+ *
+ *          Built only with SVC_STATS=1, which defines SVC_STATS. Otherwise the
+ *          hooks below are empty and svc_stats_dump() returns -1. Latency is
+ *          DWT cycles from dispatch to return, so a call that blocks includes
+ *          the time other threads ran. get_time() and get_priority() answered
+ *          by the fast path in boot.S never reach the dispatcher and are not
+ *          counted. Calls inside a batch are counted on their own and as part
+ *          of SVC_BATCH.
+ *
+ *          Bucket b counts calls that took [ 2^(b-1), 2^b ) cycles, bucket 0
+ *          calls that took none and the last bucket everything longer. Dump
+ *          it with svc_stats_dump() from user code or svc_stats in gdb.
+ */
+#ifndef _SVC_STATS_H_
+#define _SVC_STATS_H_
+
+#include <stdint.h>
+#include <dwt.h>
+#include <svc_num.h>
+
+/** @brief Histogram buckets per SVC number, the last one up to 2^23 cycles. */
+#define SVC_STATS_BUCKETS 24
+
+/**
+ * @struct svc_stats_t
+ *
+ * @brief  Statistics for one SVC number.
+ */
+typedef struct {
+  uint32_t count;                         /**< Calls dispatched */
+  uint64_t cycles;                        /**< Sum of their latencies */
+  uint32_t buckets[ SVC_STATS_BUCKETS ];  /**< log2 latency histogram */
+} svc_stats_t;
+
+#ifdef SVC_STATS
+
+/** @brief Statistics, indexed by SVC number. */
+extern svc_stats_t svc_stats[ SVC_COUNT ];
+
+/**
+ * @brief      Starts timing a call.
+ *
+ * @return     The cycle count to pass to svc_stats_record().
+ */
+static inline uint32_t svc_stats_begin( void ) {
+  return dwt_get_cycles();
+}
+
+/**
+ * @brief      Adds a finished call to the statistics.
+ *
+ * @param[in]  svc_number  The call's SVC number, below SVC_COUNT.
+ * @param[in]  start       What svc_stats_begin() returned for it.
+ */
+void svc_stats_record( uint32_t svc_number, uint32_t start );
+
+#else
+
+static inline uint32_t svc_stats_begin( void ) {
+  return 0;
+}
+
+static inline void svc_stats_record( uint32_t svc_number, uint32_t start ) {
+  ( void )svc_number; ( void )start;
+}
+
+#endif /* SVC_STATS */
+
+/**
+ * @brief      Prints the statistics of every SVC number called so far.
+ *
+ * @param[in]  reset  Clears the statistics after printing when non-zero.
+ *
+ * @return     0, or -1 if the kernel was built without SVC_STATS.
+ */
+int sys_svc_stats_dump( int reset );
+
+#endif /* _SVC_STATS_H_ */
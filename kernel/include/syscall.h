@@ -11,6 +11,9 @@
 #ifndef _SYSCALLS_H_
 #define _SYSCALLS_H_
 
+#include <stdint.h>
+#include <sys/stat.h>
+
 void *sys_sbrk(int incr);
 
 int sys_write(int file, char *ptr, int len);
@@ -19,5 +22,34 @@ int sys_read(int file, char *ptr, int len);
 
 void sys_exit(int status);
 
+/**
+ * @brief Describes stdin, stdout and stderr as character devices so newlib
+ * sizes and line buffers their streams. Other descriptors do not exist.
+ */
+int sys_fstat(int file, struct stat *st);
+
+/**
+ * @brief Returns 1 for stdin, stdout and stderr, which are the UART, else 0.
+ */
+int sys_isatty(int file);
+
+/**
+ * @brief The UART cannot seek, so this always fails.
+ */
+int sys_lseek(int file, int ptr, int dir);
+
+uint32_t sys_os_get_ticks();
+
+/**
+ * @brief Returns the DWT cycle counter, which user mode cannot read directly.
+ */
+uint32_t sys_get_cycles();
+
+/**
+ * @brief Returns microseconds since the scheduler started its timer, see
+ * timer_get_us(). Only the low 32 bits fit, so it wraps after about 71 minutes.
+ */
+uint32_t sys_get_time_us();
+
 
 #endif /* _SYSCALLS_H_ */
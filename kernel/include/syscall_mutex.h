@@ -11,6 +11,7 @@
 #define _SYSCALL_MUTEX_H_
 
 #include <unistd.h>
+#include "lock_stats.h"
 
 /**
  * @brief      The struct for a mutex.
@@ -18,7 +19,8 @@
 typedef struct {
   volatile uint32_t locked_by;
   volatile uint32_t prio_ceil;
-  // You may fill in additional fields in this struct if you require.
+  uint32_t hold_start;   /**< Cycle count when it was last locked */
+  mutex_stats_t stats;   /**< See lock_stats.h */
 } kmutex_t;
 
 /**
@@ -51,4 +53,15 @@ void sys_mutex_lock( kmutex_t *mutex );
  */
 void sys_mutex_unlock( kmutex_t *mutex );
 
+/**
+ * @brief      Copies out a mutex's statistics, see lock_stats.h.
+ *
+ * @param[in]  mutex  The mutex.
+ * @param      stats  Where to copy them.
+ * @param[in]  reset  Whether to zero them afterwards.
+ *
+ * @return     0 on success, -1 if mutex is not a mutex from mutex_init().
+ */
+int sys_mutex_stats( kmutex_t *mutex, mutex_stats_t *stats, int reset );
+
 #endif /* _SYSCALL_MUTEX_H_ */
@@ -0,0 +1,161 @@
+/** @file   syscall_sync.h
+ *
+ *  @brief  Counting semaphores, event flag groups and message queues.
+ *
+ *          Each object keeps its sleepers in wait lists from
+ *          syscall_thread.h, so they are woken in priority order and a
+ *          wakeup costs the same whatever the number of waiters. Every wait
+ *          takes a timeout in ticks: 0 only polls and WAIT_FOREVER never
+ *          expires.
+ */
+
+#ifndef _SYSCALL_SYNC_H_
+#define _SYSCALL_SYNC_H_
+
+#include <stdint.h>
+#include "syscall_thread.h"
+
+/** @brief      Objects of each kind the kernel can hand out. */
+//@{
+#define MAX_SEMAPHORES 16
+#define MAX_EVENT_GROUPS 16
+#define MAX_MSG_QUEUES 8
+//@}
+
+/**
+ * @brief      Bytes shared by the buffers of every message queue. Static
+ *             kernel data has to fit in the 16KB below the heap (see
+ *             linker_template.lds), so raise it with -D only if it still does.
+ */
+#ifndef MSG_QUEUE_POOL_SIZE
+#define MSG_QUEUE_POOL_SIZE 512
+#endif
+
+/**
+ * @brief      Options for sys_event_wait().
+ */
+//@{
+/** Wait for every flag in the mask instead of any of them. */
+#define EVENT_WAIT_ALL 0x1
+/** Clear the flags that satisfied the wait. */
+#define EVENT_CLEAR 0x2
+//@}
+
+/**
+ * @brief      A counting semaphore.
+ */
+typedef struct {
+  uint32_t count;       /**< Tokens available */
+  wait_list_t waiters;  /**< Threads in sys_sem_wait() */
+} ksem_t;
+
+/**
+ * @brief      A group of 32 event flags.
+ */
+typedef struct {
+  uint32_t flags;       /**< Flags set */
+  wait_list_t waiters;  /**< Threads in sys_event_wait() */
+} kevent_t;
+
+/**
+ * @brief      A ring of fixed-size messages, copied in and out.
+ */
+typedef struct {
+  uint8_t *buffer;      /**< capacity slots of msg_size bytes */
+  uint32_t msg_size;    /**< Bytes per message */
+  uint32_t capacity;    /**< Slots in buffer */
+  uint32_t head;        /**< Slot of the oldest message */
+  uint32_t count;       /**< Messages queued */
+  wait_list_t senders;  /**< Threads in sys_queue_send() on a full queue */
+  wait_list_t receivers; /**< Threads in sys_queue_recv() on an empty one */
+} kqueue_t;
+
+/**
+ * @brief      Frees every object, called by sys_thread_init().
+ */
+void sync_reset( void );
+
+/**
+ * @brief      Creates a semaphore.
+ *
+ * @param[in]  count  Tokens it starts with.
+ *
+ * @return     The semaphore, NULL if MAX_SEMAPHORES are in use.
+ */
+ksem_t *sys_sem_init( uint32_t count );
+
+/**
+ * @brief      Takes a token, sleeping until one is posted if there is none.
+ *
+ * @return     0 with the token, -1 on timeout or if sem is not a semaphore
+ *             from sys_sem_init().
+ */
+int sys_sem_wait( ksem_t *sem, uint32_t timeout );
+
+/**
+ * @brief      Hands a token to the highest priority waiter, or keeps it if
+ *             there is none. Does nothing if sem is not a semaphore.
+ */
+void sys_sem_post( ksem_t *sem );
+
+/**
+ * @brief      Creates an event flag group with every flag clear.
+ *
+ * @return     The group, NULL if MAX_EVENT_GROUPS are in use.
+ */
+kevent_t *sys_event_init( void );
+
+/**
+ * @brief      Waits for any, or with EVENT_WAIT_ALL every, flag in mask.
+ *
+ * @param      event    The group.
+ * @param[in]  mask     Flags of interest, not 0.
+ * @param[in]  options  EVENT_WAIT_ALL and EVENT_CLEAR.
+ * @param[in]  timeout  Ticks.
+ *
+ * @return     The flags in mask that were set, 0 on timeout or if event is
+ *             not a group from sys_event_init().
+ */
+uint32_t sys_event_wait( kevent_t *event, uint32_t mask, uint32_t options,
+                         uint32_t timeout );
+
+/**
+ * @brief      Sets flags and wakes, in priority order, every waiter they
+ *             satisfy. A waiter with EVENT_CLEAR consumes its flags before the
+ *             next one is checked. Does nothing if event is not a group.
+ */
+void sys_event_set( kevent_t *event, uint32_t flags );
+
+/**
+ * @brief      Clears flags. Does nothing if event is not a group.
+ */
+void sys_event_clear( kevent_t *event, uint32_t flags );
+
+/**
+ * @brief      Creates a message queue.
+ *
+ * @param[in]  msg_size  Bytes per message.
+ * @param[in]  capacity  Messages it holds.
+ *
+ * @return     The queue, NULL if MAX_MSG_QUEUES are in use, either argument is
+ *             0 or MSG_QUEUE_POOL_SIZE has no room for it.
+ */
+kqueue_t *sys_queue_init( uint32_t msg_size, uint32_t capacity );
+
+/**
+ * @brief      Copies a message in, sleeping while the queue is full. A waiting
+ *             receiver gets it directly.
+ *
+ * @return     0 once sent, -1 on timeout or if queue is not a queue from
+ *             sys_queue_init().
+ */
+int sys_queue_send( kqueue_t *queue, const void *msg, uint32_t timeout );
+
+/**
+ * @brief      Copies the oldest message out, sleeping while the queue is empty.
+ *
+ * @return     0 once received, -1 on timeout or if queue is not a queue.
+ */
+int sys_queue_recv( kqueue_t *queue, void *msg, uint32_t timeout );
+
+#endif /* _SYSCALL_SYNC_H_ */
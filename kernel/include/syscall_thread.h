@@ -11,13 +11,21 @@
 #define _SYSCALL_THREAD_H_
 
 #include <unistd.h>
+#include <stdint.h>
+#include "cpu_stats.h"
+#include "lock_stats.h"
 
 /**
  * @enum protection_mode
  *
  * @brief      Enums for protection mode, PER_THREAD and KERNEL_ONLY.
+ *             SHARED_STACK protects like KERNEL_ONLY and runs every thread as
+ *             run-to-completion jobs on one shared stack, see syscall_thread.c.
  */
-typedef enum { PER_THREAD = 1, KERNEL_ONLY = 0 } protection_mode;
+typedef enum { PER_THREAD = 1, KERNEL_ONLY = 0, SHARED_STACK = 2 } protection_mode;
+
+/** @brief      Maximum number of user threads. */
+#define MAX_THREADS 32
 
 /** @brief      The PendSV interrupt handler.
  */
@@ -38,7 +46,7 @@ void *pendsv_c_handler( void * );
  *                                is supplied, the kernel will provide its
  *                                own idle function that will sleep.
  * @param[in]  memory_protection  Enum for memory protection, either
- *                                PER_THREAD or KERNEL_ONLY
+ *                                PER_THREAD, KERNEL_ONLY or SHARED_STACK
  * @param[in]  max_mutexes        Maximum number of mutexes that will be
  *                                created.
  *
@@ -89,6 +97,13 @@ int sys_scheduler_start( uint32_t frequency );
  */
 uint32_t sys_get_time( void );
 
+/**
+ * @brief      Sleeps until the next interrupt. Called by the idle thread, it
+ *             also leaves out SysTick interrupts until the next tick that has
+ *             work to do, see timer_sleep().
+ */
+void sys_sleep_till_interrupt( void );
+
 /**
  * @brief      Get the effective priority of the current running thread
  *
@@ -109,10 +124,174 @@ uint32_t sys_thread_time( void );
  */
 void sys_wait_until_next_period( void );
 
+/**
+ * @brief      Get the priority of the current running thread, which doubles as
+ *             its thread id.
+ *
+ * @return     The thread's static priority
+ */
+uint32_t sys_get_pid( void );
+
+/**
+ * @brief      Copies out a thread's blocking statistics, see lock_stats.h.
+ *
+ * @param[in]  prio   The thread's priority.
+ * @param      stats  Where to copy them.
+ * @param[in]  reset  Whether to zero them afterwards.
+ *
+ * @return     0 on success, -1 if prio is not below max_threads.
+ */
+int sys_thread_block_stats( uint32_t prio, thread_block_stats_t *stats, int reset );
+
+/**
+ * @brief      The running thread's ID: its priority, or 32 for the idle and
+ *             33 for the main thread.
+ */
+uint32_t sched_current( void );
+
+/**
+ * @brief      Kills the running thread after it faulted in thread mode, just
+ *             as sys_thread_kill() would, see fault.h.
+ *
+ * @param[out] thread  The running thread's ID.
+ *
+ * @return     0 on success, -1 if it is the idle or main thread.
+ */
+int sched_fault_kill( uint32_t *thread );
+
+/**
+ * @brief      Copies out CPU utilisation over the last window, see
+ *             cpu_stats.h.
+ *
+ * @param      stats  Where to copy it.
+ *
+ * @return     0 on success, -1 before the scheduler has run a whole bucket.
+ */
+int sys_cpu_stats( cpu_stats_t *stats );
+
+/**
+ * @brief      Bracket every interrupt handler, so that handler time is
+ *             counted apart from the thread it interrupted. Nested handlers
+ *             count once, as part of the outermost.
+ */
+//@{
+void cpu_isr_enter( void );
+void cpu_isr_exit( void );
+//@}
+
+/**
+ * @brief      Blocks the current thread until futex_wake() on addr, unless
+ *             *addr no longer holds expected. The user-space mutexes in
+ *             user_common sleep on their lock word with this.
+ *
+ * @param[in]  addr      A word in user memory.
+ * @param[in]  expected  The value that means the caller should sleep.
+ *
+ * @return     0 after sleeping, -1 if *addr had changed. Either way the
+ *             caller rechecks, wakeups may be spurious.
+ */
+int sys_futex_wait( uint32_t *addr, uint32_t expected );
+
+/**
+ * @brief      Wakes every thread sleeping in futex_wait() on addr.
+ *
+ * @param[in]  addr  The word they sleep on.
+ */
+void sys_futex_wake( uint32_t *addr );
+
+/**
+ * @brief      Scheduler tick, called from the SysTick handler.
+ *
+ *             Charges the tick to the running thread, releases threads whose
+ *             period has started and pends a context switch.
+ *
+ * @param[in]  now  The tick count after this tick.
+ */
+void sched_tick( uint32_t now );
+
+/**
+ * @brief      The clock thread releases and software timers are kept in:
+ *             microseconds on the release timer when scheduler_start() could
+ *             use it, ticks otherwise. Both restart from 0 with the scheduler.
+ */
+//@{
+uint32_t sched_release_now( void );
+
+/** Release clock units per tick. */
+uint32_t sched_release_units( void );
+//@}
+
+/**
+ * @brief      Takes whatever releases are due and re-arms the release timer,
+ *             after a software timer was started or stopped. Does nothing
+ *             before the scheduler runs. Called with interrupts off.
+ */
+void sched_release_update( void );
+
+/**
+ * @brief      Starts thread index's next period, called from release_expire()
+ *             when its release is due. Moves the release one period on.
+ */
+void sched_release( uint32_t index );
+
+/**
+ * @brief      Release timer interrupt, see release_timer.h. Releases threads
+ *             whose period has started and pends a context switch.
+ */
+void sched_release_timer( void );
+
+/**
+ * @brief      Threads sleeping on a kernel object, bit i for thread i. Threads
+ *             are indexed by priority, so the lowest set bit is always the
+ *             highest priority waiter.
+ */
+typedef uint32_t wait_list_t;
+
+/** @brief      Timeout for sched_sleep() that never expires. */
+#define WAIT_FOREVER 0xFFFFFFFFU
+
+/**
+ * @brief      Puts the current thread to sleep on a wait list until
+ *             sched_wake() or the timeout.
+ *
+ *             Call with interrupts disabled. The switch happens inside, with
+ *             the interrupt state restored, and interrupts are disabled again
+ *             on return.
+ *
+ * @param      list     The wait list.
+ * @param      record   Handed to the waker by sched_wait_record().
+ * @param[in]  timeout  Ticks to wait at most, or WAIT_FOREVER. 0 does not
+ *                      sleep.
+ * @param      state    What save_interrupt_state_and_disable() returned.
+ *
+ * @return     0 if woken by sched_wake(), -1 on timeout or if the caller is
+ *             not a user thread.
+ */
+int sched_sleep( wait_list_t *list, void *record, uint32_t timeout, int *state );
+
+/**
+ * @brief      The record a sleeping thread gave sched_sleep().
+ */
+void *sched_wait_record( uint32_t index );
+
+/**
+ * @brief      Takes a thread off its wait list and makes it runnable. Call
+ *             with interrupts disabled.
+ *
+ * @param      list   The wait list it sleeps on.
+ * @param[in]  index  The thread.
+ */
+void sched_wake( wait_list_t *list, uint32_t index );
+
 /**
 * @brief      Kills current running thread. Aborts program if current thread is
-*             main thread or the idle thread or if current thread exited
-*             while holding a mutex.
+*             main thread or the idle thread.
+*
+*             Mutexes the thread still holds are unlocked first, waking the
+*             threads they blocked. Whatever they guard may be half updated,
+*             but left locked they would block every thread sharing them for
+*             good. This holds however a thread dies: by thread_kill(), by
+*             returning from its function or by a fault.
 *
 * @return     Does not return.
 */
@@ -0,0 +1,128 @@
+/** @file   syscall_timer.h
+ *
+ *  @brief  Software timers, expired through a user-mode daemon thread.
+ *
+ *          Running timers and the next period start of every live thread
+ *          share one binary heap, ordered by time in the release clock (see
+ *          release_now() in syscall_thread.c). Each release update takes what
+ *          is due off the root and arms the release timer for the new root, so
+ *          a release or an expiry costs O(log n) and never waits for a tick.
+ *          Expired timers are handed to a thread sleeping in sys_timer_wait(),
+ *          which calls the callback in user mode, or queued until one asks. A
+ *          timer that expires again while still queued runs its callback once.
+ *
+ *          Delays and periods are in ticks. Timers started before
+ *          scheduler_start() count from it.
+ */
+
+#ifndef _SYSCALL_TIMER_H_
+#define _SYSCALL_TIMER_H_
+
+#include <stdint.h>
+
+/**
+ * @brief      Timers the kernel can hand out. Each costs 40 bytes of static
+ *             data, so like MSG_QUEUE_POOL_SIZE it can be raised with -D only
+ *             as long as that still fits.
+ */
+#ifndef MAX_SW_TIMERS
+#define MAX_SW_TIMERS 16
+#endif
+
+/**
+ * @brief      An entry of the release heap.
+ */
+typedef struct {
+  uint32_t at;       /**< When it is due, in the release clock */
+  uint32_t id;       /**< Thread index, or MAX_THREADS plus the timer index */
+  int32_t heap_pos;  /**< Index in the heap, -1 while not in it */
+} release_node_t;
+
+/**
+ * @brief      A software timer.
+ */
+typedef struct {
+  void *callback;    /**< Called by the daemon with arg */
+  void *arg;         /**< Argument for callback */
+  uint32_t delay;    /**< Ticks to the first expiry */
+  uint32_t period;   /**< Ticks between expiries, 0 for one-shot */
+  release_node_t node; /**< Next expiry, in the heap while running */
+  int32_t next;      /**< Next timer in the expired queue, -1 for none */
+  int queued;        /**< Whether it is in the expired queue */
+} ktimer_t;
+
+/**
+ * @brief      Frees every timer and empties the heap, called by
+ *             sys_thread_init().
+ */
+void timer_reset( void );
+
+/**
+ * @brief      Restarts every running timer from its delay and reorders the
+ *             heap, called by sys_scheduler_start() once the release clock
+ *             starts from 0 and the thread releases are rebased onto it.
+ */
+void timer_rebase( void );
+
+/**
+ * @brief      Puts a node in the heap, or moves it after its time changed.
+ *             Called with interrupts off.
+ */
+void release_schedule( release_node_t *node );
+
+/**
+ * @brief      Takes a node out of the heap, if it is there. Called with
+ *             interrupts off.
+ */
+void release_cancel( release_node_t *node );
+
+/**
+ * @brief      Starts the periods and expires the timers due at now, re-arming
+ *             the periodic timers. Called with interrupts off from the release
+ *             update.
+ */
+void release_expire( uint32_t now );
+
+/**
+ * @brief      Finds the next release or expiry.
+ *
+ * @param[out] at    Its time, if there is one.
+ *
+ * @return     1 if the heap is not empty, 0 otherwise.
+ */
+int release_next( uint32_t *at );
+
+/**
+ * @brief      Creates a stopped timer.
+ *
+ * @return     The timer, NULL if MAX_SW_TIMERS are in use.
+ */
+ktimer_t *sys_timer_create( void *callback, void *arg );
+
+/**
+ * @brief      Starts or restarts a timer.
+ *
+ * @param[in]  delay   Ticks to the first expiry, 0 for the next update.
+ * @param[in]  period  Ticks between later expiries, 0 for a one-shot timer.
+ *
+ * @return     0 on success, -1 if timer is not from sys_timer_create().
+ */
+int sys_timer_start( ktimer_t *timer, uint32_t delay, uint32_t period );
+
+/**
+ * @brief      Stops a timer, dropping an expiry the daemon has not taken yet.
+ *
+ * @return     0 on success, -1 if timer is not from sys_timer_create().
+ */
+int sys_timer_stop( ktimer_t *timer );
+
+/**
+ * @brief      Takes the oldest expired timer, sleeping until one expires.
+ *
+ * @param[out] arg   The timer's argument.
+ *
+ * @return     The timer's callback, NULL if the calling thread cannot sleep.
+ */
+void *sys_timer_wait( void **arg );
+
+#endif /* _SYSCALL_TIMER_H_ */
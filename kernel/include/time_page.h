@@ -0,0 +1,58 @@
+/** @file time_page.h
+ *
+ *  @brief  Kernel state that user mode reads without a system call.
+ *
+ *          The kernel keeps the tick count, the running thread's time and
+ *          priority and the ceilings other threads hold in one 32-byte,
+ *          32-byte aligned page. get_time(), thread_time(), get_priority()
+ *          and _os_get_ticks() in user_common/src/349_lib.c read it directly,
+ *          and so does the fast mutex in 349_fast_mutex.c. Each field is a
+ *          single word written only from handlers, so a read is never torn,
+ *          and a thread always sees its own values because the page is
+ *          rewritten on every context switch.
+ *
+ *          The linker script puts the page at TIME_PAGE_ADDR, and user code
+ *          reads it through TIME_PAGE rather than the kernel's symbol. The
+ *          kernel does not turn the MPU on, so user mode reads the page like
+ *          any other SRAM. Its size and alignment make it exactly one MPU
+ *          region, to be mapped read-only for user mode once protection is
+ *          enabled.
+ */
+#ifndef _TIME_PAGE_H_
+#define _TIME_PAGE_H_
+
+#include <stdint.h>
+
+/** @brief log2 of the page size, the smallest MPU region. */
+#define TIME_PAGE_SIZE_LOG2 5
+
+/** @brief Address of the page, the start of SRAM. */
+#define TIME_PAGE_ADDR 0x20000000
+
+/**
+ * @struct time_page_t
+ *
+ * @brief  Layout of the page. boot.S reads ticks and priority by offset.
+ */
+typedef struct {
+  volatile uint32_t ticks;       /**< SysTick ticks since timer_start() */
+  volatile uint32_t thread_time; /**< Ticks the running thread has run */
+  volatile uint32_t priority;    /**< Running thread's effective priority */
+  volatile uint32_t ceilings;    /**< Bit c while another thread holds ceiling c */
+  uint32_t reserved[ 4 ];        /**< Pads the page to its MPU region size */
+} time_page_t;
+
+/** @brief The page, owned by syscall_thread.c. */
+extern time_page_t time_page;
+
+/**
+ * @brief The page as user code sees it. The simulator links the kernel and
+ *        the user program into one process, so there it is just the symbol.
+ */
+#ifdef HOST_SIM
+#define TIME_PAGE ( ( const time_page_t * )&time_page )
+#else
+#define TIME_PAGE ( ( const time_page_t * )TIME_PAGE_ADDR )
+#endif
+
+#endif /* _TIME_PAGE_H_ */
@@ -11,10 +11,51 @@
 #ifndef _TIMER_H_
 #define _TIMER_H_
 
+#include <stdint.h>
+
 int timer_start(int frequency);
 
 void timer_stop();
 
-void systick_c_handler();
+uint32_t systick_get_millis();
+
+/**
+ * @brief Reads the time since timer_start() in SysTick counter clocks: the tick
+ * count plus how far the counter is into the current tick. Safe from any
+ * context, including a tick that is pending but not yet handled.
+ *
+ * @return The count, 0 if the timer has not been started.
+ */
+uint64_t timer_get_counts( void );
+
+/**
+ * @brief Counter clocks per tick, 0 if the timer has not been started.
+ */
+uint32_t timer_get_tick_counts( void );
+
+/**
+ * @brief Sleeps until an interrupt, skipping up to max_ticks - 1 SysTick
+ * interrupts on the way. SysTick is reprogrammed to fire on the tick boundary
+ * max_ticks ahead, and on wakeup the tick count is advanced by the boundaries
+ * that passed and SysTick goes back to its grid. Called with interrupts
+ * disabled, so the count is correct before any handler runs.
+ *
+ * @param max_ticks Tick boundaries ahead of the first that has work to do.
+ */
+void timer_sleep( uint32_t max_ticks );
+
+/**
+ * @brief Microseconds since timer_start(), from timer_get_counts().
+ */
+uint64_t timer_get_us( void );
+
+/**
+ * @brief SysTick interrupt, entered from _sys_tick_asm_ in boot.S.
+ *
+ * @param val        STK_VAL read on entry, for irq_latency.h.
+ * @param frame      The exception frame.
+ * @param exc_return lr on exception entry.
+ */
+void systick_c_handler( uint32_t val, uint32_t *frame, uint32_t exc_return );
 
 #endif /* _TIMER_H_ */
\ No newline at end of file
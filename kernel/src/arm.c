@@ -38,6 +38,8 @@
 //@{
 #define SHCSR ((volatile uint32_t *) 0xE000ED24)
 #define SHCSR_USGFAULTENA (1 << 18)
+#define SHCSR_BUSFAULTENA (1 << 17)
+#define SHCSR_MEMFAULTENA (1 << 16)
 #define SHCSR_SVCALLACT (1 << 7)
 //@}
 
@@ -51,8 +53,9 @@ void init_349( void ){
   // Enable return to thread mode when exceptions are active.
   *CCR |= CCR_NONBASETHRDENA;
 
-  // activate usage fault
-  *SHCSR |= SHCSR_USGFAULTENA;
+  // activate usage, bus and mm faults, rather than escalating them all to
+  // hard fault
+  *SHCSR |= SHCSR_USGFAULTENA | SHCSR_BUSFAULTENA | SHCSR_MEMFAULTENA;
 
   // Set SVC handler priority to 2
   *SHPR2 |= 0x20000000;
@@ -0,0 +1,43 @@
+/** @file boot_time.c
+ *
+ *  @brief  Boot phase timing report.
+ */
+
+#include <boot_time.h>
+#include <printk.h>
+
+uint32_t boot_marks[ BOOT_MARK_COUNT ];
+
+/** @brief Printable names of the boot phases, indexed by boot_mark. */
+static const char *boot_mark_names[ BOOT_MARK_COUNT ] = {
+  "data/bss",
+  "init_349",
+  "clock_init",
+  "uart_init",
+  "timer_start",
+  "user entry"
+};
+
+/**
+ * @brief      Cycle budget for each boot phase, indexed by boot_mark. A phase
+ *             whose cost exceeds its budget is flagged in the report. 0 means
+ *             the phase has no budget.
+ */
+static const uint32_t boot_mark_budgets[ BOOT_MARK_COUNT ] = {
+  0, 0, 0, 0, 0, 0
+};
+
+void boot_time_report( void ) {
+  uint32_t prev = 0;
+
+  printk( "Boot phase timing (cycles):\n" );
+  for ( int i = 0; i < BOOT_MARK_COUNT; i++ ) {
+    uint32_t cost = boot_marks[ i ] - prev;
+    printk( "  %s: %u (at %u)", boot_mark_names[ i ], cost, boot_marks[ i ] );
+    if ( boot_mark_budgets[ i ] && cost > boot_mark_budgets[ i ] ) {
+      printk( " OVER BUDGET %u", boot_mark_budgets[ i ] );
+    }
+    printk( "\n" );
+    prev = boot_marks[ i ];
+  }
+}
@@ -0,0 +1,206 @@
+/** @file clock.c
+ *
+ *  @brief  PLL, flash wait state and ART accelerator configuration.
+ */
+
+#include <clock.h>
+#include <rcc.h>
+
+/** @brief The flash interface register map. */
+struct flash_reg_map {
+  volatile uint32_t acr;     /**< 0  - Access control */
+  volatile uint32_t keyr;    /**< 4  - Key */
+  volatile uint32_t optkeyr; /**< 8  - Option key */
+  volatile uint32_t sr;      /**< C  - Status */
+  volatile uint32_t cr;      /**< 10 - Control */
+  volatile uint32_t optcr;   /**< 14 - Option control */
+};
+
+/** @brief Base address of the flash interface */
+#define FLASH_BASE ( struct flash_reg_map * ) 0x40023C00
+
+/** @brief FLASH_ACR fields */
+//@{
+#define ACR_LATENCY_MASK ( 0xF )
+#define ACR_PRFTEN ( 1 << 8 )
+#define ACR_ICEN ( 1 << 9 )
+#define ACR_DCEN ( 1 << 10 )
+#define ACR_ICRST ( 1 << 11 )
+#define ACR_DCRST ( 1 << 12 )
+//@}
+
+/** @brief Power control register and voltage scaling field */
+//@{
+#define PWR_CR ( ( volatile uint32_t * ) 0x40007000 )
+#define PWR_CR_VOS_MASK ( 0x3 << 14 )
+#define PWR_CR_VOS_SCALE2 ( 0x2 << 14 )
+//@}
+
+/** @brief RCC_CR fields */
+//@{
+#define CR_HSION ( 1 << 0 )
+#define CR_HSIRDY ( 1 << 1 )
+#define CR_PLLON ( 1 << 24 )
+#define CR_PLLRDY ( 1 << 25 )
+//@}
+
+/** @brief RCC_PLLCFGR fields */
+//@{
+#define PLLCFGR_PLLM_SHIFT 0
+#define PLLCFGR_PLLN_SHIFT 6
+#define PLLCFGR_PLLP_SHIFT 16
+#define PLLCFGR_PLLSRC_HSE ( 1 << 22 )
+#define PLLCFGR_PLLQ_SHIFT 24
+#define PLLCFGR_MASK ( 0x3F | ( 0x1FF << 6 ) | ( 0x3 << 16 ) | \
+                       PLLCFGR_PLLSRC_HSE | ( 0xF << 24 ) )
+//@}
+
+/** @brief RCC_CFGR fields */
+//@{
+#define CFGR_SW_MASK ( 0x3 )
+#define CFGR_SW_HSI ( 0x0 )
+#define CFGR_SW_PLL ( 0x2 )
+#define CFGR_SWS_MASK ( 0x3 << 2 )
+#define CFGR_SWS_HSI ( 0x0 << 2 )
+#define CFGR_SWS_PLL ( 0x2 << 2 )
+#define CFGR_HPRE_MASK ( 0xF << 4 )
+#define CFGR_PPRE1_SHIFT 10
+#define CFGR_PPRE1_MASK ( 0x7 << CFGR_PPRE1_SHIFT )
+#define CFGR_PPRE2_MASK ( 0x7 << 13 )
+//@}
+
+/** @brief Enable bit for the power interface clock in RCC_APB1ENR */
+#define APB1ENR_PWREN ( 1 << 28 )
+
+/** @brief PLL input after the PLLM divider, the value ST recommends. */
+#define PLL_VCO_IN_HZ 1000000
+/** @brief Legal VCO output range */
+//@{
+#define PLL_VCO_MIN_HZ 192000000
+#define PLL_VCO_MAX_HZ 432000000
+//@}
+/** @brief Target for the 48 MHz (USB/SDIO) PLL output */
+#define PLL_48M_HZ 48000000
+/** @brief Flash can run this fast per wait state at 2.7 - 3.6 V. */
+#define FLASH_HZ_PER_WAIT_STATE 30000000
+
+/** @brief Current clock frequencies, published for drivers. */
+//@{
+static uint32_t sysclk_hz = CLOCK_HSI_HZ;
+static uint32_t pclk1_hz = CLOCK_HSI_HZ;
+static uint32_t pclk2_hz = CLOCK_HSI_HZ;
+//@}
+
+/**
+ * @brief      Switches SYSCLK back to the HSI and turns the PLL off so it can
+ *             be reprogrammed.
+ */
+static void clock_use_hsi( struct rcc_reg_map *rcc ) {
+  rcc->cr |= CR_HSION;
+  while ( !( rcc->cr & CR_HSIRDY ) );
+
+  rcc->cfgr = ( rcc->cfgr & ~CFGR_SW_MASK ) | CFGR_SW_HSI;
+  while ( ( rcc->cfgr & CFGR_SWS_MASK ) != CFGR_SWS_HSI );
+
+  rcc->cr &= ~CR_PLLON;
+  while ( rcc->cr & CR_PLLRDY );
+}
+
+/**
+ * @brief      Programs the flash wait states for the given HCLK and enables
+ *             prefetch and both ART caches, flushing the caches first so no
+ *             stale lines survive the latency change.
+ */
+static void flash_configure( uint32_t hclk_hz ) {
+  struct flash_reg_map *flash = FLASH_BASE;
+  uint32_t latency = ( hclk_hz - 1 ) / FLASH_HZ_PER_WAIT_STATE;
+
+  flash->acr &= ~( ACR_ICEN | ACR_DCEN );
+  flash->acr |= ACR_ICRST | ACR_DCRST;
+  flash->acr &= ~( ACR_ICRST | ACR_DCRST );
+
+  flash->acr = ( flash->acr & ~ACR_LATENCY_MASK ) | latency;
+  while ( ( flash->acr & ACR_LATENCY_MASK ) != latency );
+
+  flash->acr |= ACR_PRFTEN | ACR_ICEN | ACR_DCEN;
+}
+
+int clock_init( uint32_t target_hz ) {
+  struct rcc_reg_map *rcc = RCC_BASE;
+  uint32_t pllp = 0, plln = 0, pllq, vco_hz = 0, ppre1 = 0;
+
+  if ( target_hz == 0 || target_hz > CLOCK_SYSCLK_MAX_HZ ||
+       target_hz % PLL_VCO_IN_HZ ) {
+    return -1;
+  }
+
+  // Pick the smallest P (2, 4, 6, 8) that puts the VCO in range.
+  for ( uint32_t p = 2; p <= 8; p += 2 ) {
+    if ( target_hz * p >= PLL_VCO_MIN_HZ && target_hz * p <= PLL_VCO_MAX_HZ ) {
+      pllp = p;
+      vco_hz = target_hz * p;
+      plln = vco_hz / PLL_VCO_IN_HZ;
+      break;
+    }
+  }
+  if ( !pllp ) {
+    return -1;
+  }
+
+  // Keep the 48 MHz output at or below 48 MHz; Q must be 2..15.
+  pllq = ( vco_hz + PLL_48M_HZ - 1 ) / PLL_48M_HZ;
+  if ( pllq < 2 ) pllq = 2;
+
+  // APB1 prescaler encoding: 0xx = /1, 100 = /2, 101 = /4, 110 = /8, 111 = /16
+  uint32_t apb1_div = 1;
+  while ( target_hz / apb1_div > CLOCK_PCLK1_MAX_HZ ) {
+    apb1_div <<= 1;
+    ppre1 = ppre1 ? ppre1 + 1 : 0x4;
+  }
+
+  clock_use_hsi( rcc );
+
+  // Scale 2 is enough for 84 MHz on the F401.
+  rcc->apb1_enr |= APB1ENR_PWREN;
+  *PWR_CR = ( *PWR_CR & ~PWR_CR_VOS_MASK ) | PWR_CR_VOS_SCALE2;
+
+  rcc->pll_cfgr = ( rcc->pll_cfgr & ~PLLCFGR_MASK ) |
+    ( ( CLOCK_HSI_HZ / PLL_VCO_IN_HZ ) << PLLCFGR_PLLM_SHIFT ) |
+    ( plln << PLLCFGR_PLLN_SHIFT ) |
+    ( ( pllp / 2 - 1 ) << PLLCFGR_PLLP_SHIFT ) |
+    ( pllq << PLLCFGR_PLLQ_SHIFT );
+
+  rcc->cr |= CR_PLLON;
+  while ( !( rcc->cr & CR_PLLRDY ) );
+
+  // Wait states have to be in place before the core speeds up.
+  flash_configure( target_hz );
+
+  rcc->cfgr = ( rcc->cfgr & ~( CFGR_HPRE_MASK | CFGR_PPRE1_MASK | CFGR_PPRE2_MASK ) ) |
+    ( ppre1 << CFGR_PPRE1_SHIFT );
+
+  rcc->cfgr = ( rcc->cfgr & ~CFGR_SW_MASK ) | CFGR_SW_PLL;
+  while ( ( rcc->cfgr & CFGR_SWS_MASK ) != CFGR_SWS_PLL );
+
+  sysclk_hz = target_hz;
+  pclk1_hz = target_hz / apb1_div;
+  pclk2_hz = target_hz;
+
+  return 0;
+}
+
+uint32_t clock_get_sysclk_hz( void ) {
+  return sysclk_hz;
+}
+
+uint32_t clock_get_hclk_hz( void ) {
+  return sysclk_hz;
+}
+
+uint32_t clock_get_pclk1_hz( void ) {
+  return pclk1_hz;
+}
+
+uint32_t clock_get_pclk2_hz( void ) {
+  return pclk2_hz;
+}
@@ -0,0 +1,91 @@
+/** @file   context.c
+ *
+ *  @brief  Cortex-M4 thread context construction.
+ *
+ *          A switched-out thread has the hardware exception frame on its
+ *          process stack and the rest of its state, pushed by _pend_sv_, on its
+ *          kernel stack. A new thread gets the same two frames built by hand.
+ */
+
+#include <context.h>
+
+/** @brief      Initial XPSR value, all 0s except thumb bit. */
+#define XPSR_INIT 0x1000000
+
+/** @brief Interrupt return code to user mode using PSP.*/
+#define LR_RETURN_TO_USER_PSP 0xFFFFFFFD
+
+/**
+ * @struct interrupt_stack_frame
+ *
+ * @brief  Stack frame upon exception.
+ */
+typedef struct {
+  uint32_t r0;   /** @brief Register value for r0 */
+  uint32_t r1;   /** @brief Register value for r1 */
+  uint32_t r2;   /** @brief Register value for r2 */
+  uint32_t r3;   /** @brief Register value for r3 */
+  uint32_t r12;  /** @brief Register value for r12 */
+  uint32_t lr;   /** @brief Register value for lr*/
+  uint32_t pc;   /** @brief Register value for pc */
+  uint32_t xPSR; /** @brief Register value for xPSR */
+} interrupt_stack_frame;
+
+/**
+ * @struct switch_frame
+ *
+ * @brief  State pushed on the kernel stack by _pend_sv_, lowest address
+ *         first. The context pointer points at this frame.
+ */
+typedef struct {
+  uint32_t psp;        /** @brief Process stack pointer */
+  uint32_t r4;         /** @brief Register value for r4 */
+  uint32_t r5;         /** @brief Register value for r5 */
+  uint32_t r6;         /** @brief Register value for r6 */
+  uint32_t r7;         /** @brief Register value for r7 */
+  uint32_t r8;         /** @brief Register value for r8 */
+  uint32_t r9;         /** @brief Register value for r9 */
+  uint32_t r10;        /** @brief Register value for r10 */
+  uint32_t r11;        /** @brief Register value for r11 */
+  uint32_t exc_return; /** @brief EXC_RETURN value for the PendSV return */
+} switch_frame;
+
+_Static_assert( sizeof( switch_frame ) == CONTEXT_KSTACK_BYTES,
+                "context.h must match the frame _pend_sv_ pushes" );
+
+void *context_init( void *kstack_top,
+                    void *ustack_top,
+                    void *fn,
+                    void *vargp,
+                    void *exit_fn ){
+  interrupt_stack_frame *frame = ( interrupt_stack_frame * )ustack_top - 1;
+  switch_frame *context = ( switch_frame * )kstack_top - 1;
+
+  frame->r0 = ( uint32_t )vargp;
+  frame->r1 = 0;
+  frame->r2 = 0;
+  frame->r3 = 0;
+  frame->r12 = 0;
+  frame->lr = ( uint32_t )exit_fn;
+  // The exception return address must not have the thumb bit set.
+  frame->pc = ( uint32_t )fn & ~1U;
+  frame->xPSR = XPSR_INIT;
+
+  context->psp = ( uint32_t )frame;
+  context->r4 = 0;
+  context->r5 = 0;
+  context->r6 = 0;
+  context->r7 = 0;
+  context->r8 = 0;
+  context->r9 = 0;
+  context->r10 = 0;
+  context->r11 = 0;
+  context->exc_return = LR_RETURN_TO_USER_PSP;
+
+  return context;
+}
+
+void context_stack_limits( void *context, void **kstack_top, void **ustack_top ){
+  *kstack_top = context;
+  *ustack_top = ( void * )( ( switch_frame * )context )->psp;
+}
@@ -0,0 +1,199 @@
+/** @file   fault.c
+ *
+ *  @brief  Fault handlers and the crash log, see fault.h.
+ */
+
+#include <stddef.h>
+#include <kstring.h>
+#include <arm.h>
+#include <fault.h>
+#include <printk.h>
+#include <syscall_thread.h>
+#include <uart.h>
+
+/** @brief System control block fault registers. */
+//@{
+#define CFSR ( ( volatile uint32_t * )0xE000ED28 )
+#define HFSR ( ( volatile uint32_t * )0xE000ED2C )
+#define MMFAR ( ( volatile uint32_t * )0xE000ED34 )
+#define BFAR ( ( volatile uint32_t * )0xE000ED38 )
+//@}
+
+/** @brief CFSR flags. */
+//@{
+#define CFSR_MSTKERR ( 1 << 4 )
+#define CFSR_MMARVALID ( 1 << 7 )
+#define CFSR_STKERR ( 1 << 12 )
+#define CFSR_BFARVALID ( 1 << 15 )
+//@}
+
+/** @brief Application interrupt and reset control register and flags. */
+//@{
+#define AIRCR ( ( volatile uint32_t * )0xE000ED0C )
+#define AIRCR_VECTKEY ( 0x05FA << 16 )
+#define AIRCR_SYSRESETREQ ( 1 << 2 )
+//@}
+
+/** @brief Debug halting control and status register and flags. */
+//@{
+#define DHCSR ( ( volatile uint32_t * )0xE000EDF0 )
+#define DHCSR_C_DEBUGEN ( 1 << 0 )
+//@}
+
+/** @brief EXC_RETURN bit set when the exception returns to thread mode. */
+#define EXC_RETURN_THREAD ( 1 << 3 )
+
+/** @brief SRAM, where any exception frame has to be. */
+//@{
+#define SRAM_START 0x20000000
+#define SRAM_END 0x20018000
+//@}
+
+/** @brief Marks an initialised crash log. */
+#define FAULT_LOG_MAGIC 0xC4A54106
+
+/**
+ * @struct fault_log_t
+ *
+ * @brief      The crash log, a ring of the last FAULT_RECORDS records.
+ */
+typedef struct {
+  uint32_t magic;    /**< FAULT_LOG_MAGIC */
+  uint32_t count;    /**< Faults recorded since power up */
+  fault_record_t records[ FAULT_RECORDS ];
+  uint32_t check;    /**< Sum of the words above */
+} fault_log_t;
+
+/** @brief The crash log, kept across resets. */
+static fault_log_t fault_log __attribute__( ( section( ".noinit" ) ) );
+
+/** @brief Printable names of the fault types, indexed by fault_type. */
+static const char *fault_names[] = { "HardFault", "MemManage", "BusFault",
+                                     "UsageFault" };
+
+/**
+ * @brief      Sum of every word of the log but check.
+ */
+static uint32_t fault_log_sum( void ) {
+  uint32_t *word = ( uint32_t * )&fault_log;
+  uint32_t sum = 0;
+
+  for ( uint32_t i = 0; i < offsetof( fault_log_t, check ) / 4; i++ ) {
+    sum += word[ i ];
+  }
+  return sum;
+}
+
+/**
+ * @brief      Starts an empty log unless SRAM still holds a valid one, as it
+ *             does after a reset but not after power up.
+ */
+static void fault_log_check( void ) {
+  if ( fault_log.magic != FAULT_LOG_MAGIC || fault_log.check != fault_log_sum() ) {
+    k_memset( &fault_log, 0, sizeof( fault_log ) );
+    fault_log.magic = FAULT_LOG_MAGIC;
+    fault_log.check = fault_log_sum();
+  }
+}
+
+/**
+ * @brief      Prints a record over printk.
+ */
+static void fault_print( fault_record_t *record ) {
+  record->reported = 1;
+  printk( "Fault %u: %s in thread %u, CFSR %x HFSR %x", record->seq,
+          fault_names[ record->type & 3 ], record->thread, record->cfsr,
+          record->hfsr );
+  if ( record->cfsr & CFSR_MMARVALID ) {
+    printk( " MMFAR %x", record->mmfar );
+  }
+  if ( record->cfsr & CFSR_BFARVALID ) {
+    printk( " BFAR %x", record->bfar );
+  }
+  printk( " lr %x\n", record->exc_return );
+  if ( record->frame_valid ) {
+    printk( "  r0 %x r1 %x r2 %x r3 %x r12 %x\n", record->frame[ 0 ],
+            record->frame[ 1 ], record->frame[ 2 ], record->frame[ 3 ],
+            record->frame[ 4 ] );
+    printk( "  lr %x pc %x xpsr %x\n", record->frame[ 5 ], record->frame[ 6 ],
+            record->frame[ 7 ] );
+  } else {
+    printk( "  no exception frame\n" );
+  }
+}
+
+void fault_report( void ) {
+  uint32_t first;
+
+  fault_log_check();
+  first = fault_log.count > FAULT_RECORDS ? fault_log.count - FAULT_RECORDS : 0;
+  for ( uint32_t seq = first; seq < fault_log.count; seq++ ) {
+    fault_record_t *record = &fault_log.records[ seq % FAULT_RECORDS ];
+
+    if ( !record->reported ) {
+      printk( "Before the last reset:\n" );
+      fault_print( record );
+    }
+  }
+  fault_log.check = fault_log_sum();
+}
+
+/**
+ * @brief      Gives up on the board: resets it, or with a debugger attached
+ *             stops where the fault left it.
+ */
+static void fault_fatal( void ) {
+  uart_flush();
+  if ( *DHCSR & DHCSR_C_DEBUGEN ) {
+    breakpoint();
+  }
+  *AIRCR = AIRCR_VECTKEY | AIRCR_SYSRESETREQ;
+  data_sync_barrier();
+  while ( 1 );
+}
+
+void fault_c_handler( uint32_t *frame, uint32_t type, uint32_t exc_return ) {
+  uint32_t thread = FAULT_NO_THREAD;
+  fault_record_t *record;
+
+  fault_log_check();
+  record = &fault_log.records[ fault_log.count % FAULT_RECORDS ];
+  k_memset( record, 0, sizeof( *record ) );
+  record->seq = fault_log.count;
+  record->type = type;
+  record->cfsr = *CFSR;
+  record->hfsr = *HFSR;
+  record->mmfar = *MMFAR;
+  record->bfar = *BFAR;
+  record->exc_return = exc_return;
+  // The status bits are write one to clear.
+  *CFSR = record->cfsr;
+  *HFSR = record->hfsr;
+
+  // Reading a frame that failed to stack could fault again, inside this one.
+  if ( !( record->cfsr & ( CFSR_MSTKERR | CFSR_STKERR ) ) &&
+       ( uint32_t )frame >= SRAM_START && ( uint32_t )frame <= SRAM_END - 32 ) {
+    k_memcpy( record->frame, frame, sizeof( record->frame ) );
+    record->frame_valid = 1;
+  }
+
+  // A thread can be killed with nothing else lost, even after a stacking
+  // error, since its stacks are dropped with it.
+  if ( exc_return & EXC_RETURN_THREAD ) {
+    record->killed = sched_fault_kill( &thread ) == 0;
+  }
+  record->thread = thread;
+
+  // A record that resets the board is printed again after the reset, in
+  // case this output never leaves the UART.
+  fault_print( record );
+  record->reported = record->killed;
+  fault_log.count++;
+  fault_log.check = fault_log_sum();
+
+  if ( !record->killed ) {
+    fault_fatal();
+  }
+  // The kill pended a switch, which runs before the thread could resume.
+  printk( "Thread %u killed\n", thread );
+}
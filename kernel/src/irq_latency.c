@@ -0,0 +1,100 @@
+/** @file irq_latency.c
+ *
+ *  @brief  SysTick interrupt latency samples, see irq_latency.h.
+ */
+
+#include <arm.h>
+#include <kstring.h>
+#include <printk.h>
+#include <irq_latency.h>
+#include <syscall_thread.h>
+
+#ifdef IRQ_LATENCY
+
+/** @brief EXC_RETURN bit set when the exception returns to thread mode. */
+#define EXC_RETURN_THREAD ( 1 << 3 )
+
+irq_latency_t irq_latency;
+
+void irq_latency_record( uint32_t cycles, uint32_t *frame, uint32_t exc_return ) {
+  uint32_t bucket = cycles ? 32 - __builtin_clz( cycles ) : 0;
+  uint32_t thread = sched_current();
+  irq_latency_thread_t *stats = &irq_latency.threads[ thread ];
+  int i;
+
+  if ( bucket >= IRQ_LATENCY_BUCKETS ) {
+    bucket = IRQ_LATENCY_BUCKETS - 1;
+  }
+
+  if ( !irq_latency.count || cycles < irq_latency.min ) irq_latency.min = cycles;
+  if ( cycles > irq_latency.max ) irq_latency.max = cycles;
+  irq_latency.count++;
+  irq_latency.cycles += cycles;
+  irq_latency.buckets[ bucket ]++;
+
+  stats->count++;
+  stats->cycles += cycles;
+  if ( cycles > stats->max ) stats->max = cycles;
+
+  // Insertion into the worst list, longest first.
+  for ( i = IRQ_LATENCY_WORST; i > 0 && cycles > irq_latency.worst[ i - 1 ].cycles; i-- ) {
+    if ( i < IRQ_LATENCY_WORST ) {
+      irq_latency.worst[ i ] = irq_latency.worst[ i - 1 ];
+    }
+  }
+  if ( i < IRQ_LATENCY_WORST ) {
+    irq_latency.worst[ i ] = ( irq_latency_sample_t ){
+      .cycles = cycles,
+      .pc = frame[ 6 ],
+      .thread = thread,
+      .handler = !( exc_return & EXC_RETURN_THREAD ),
+    };
+  }
+}
+
+int sys_irq_latency_dump( int reset ) {
+  printk( "irq_latency,samples,min,avg,max,buckets\n" );
+  if ( irq_latency.count ) {
+    printk( "systick,%u,%u,%u,%u,", irq_latency.count, irq_latency.min,
+            ( uint32_t )( irq_latency.cycles / irq_latency.count ),
+            irq_latency.max );
+    for ( int b = 0; b < IRQ_LATENCY_BUCKETS; b++ ) {
+      printk( b ? " %u" : "%u", irq_latency.buckets[ b ] );
+    }
+    printk( "\n" );
+  }
+
+  printk( "irq_latency_thread,thread,samples,avg,max\n" );
+  for ( int i = 0; i < IRQ_LATENCY_THREADS; i++ ) {
+    irq_latency_thread_t *stats = &irq_latency.threads[ i ];
+
+    if ( stats->count ) {
+      printk( "thread,%d,%u,%u,%u\n", i, stats->count,
+              ( uint32_t )( stats->cycles / stats->count ), stats->max );
+    }
+  }
+
+  printk( "irq_latency_worst,cycles,thread,mode,pc\n" );
+  for ( int i = 0; i < IRQ_LATENCY_WORST && irq_latency.worst[ i ].cycles; i++ ) {
+    irq_latency_sample_t *sample = &irq_latency.worst[ i ];
+
+    printk( "worst,%u,%u,%s,%x\n", sample->cycles, sample->thread,
+            sample->handler ? "handler" : "thread", sample->pc );
+  }
+
+  if ( reset ) {
+    int state = save_interrupt_state_and_disable();
+    k_memset( &irq_latency, 0, sizeof( irq_latency ) );
+    restore_interrupt_state( state );
+  }
+  return 0;
+}
+
+#else
+
+int sys_irq_latency_dump( int reset ) {
+  ( void )reset;
+  return -1;
+}
+
+#endif /* IRQ_LATENCY */
@@ -9,12 +9,16 @@
  */
 
 #include "arm.h"
+#include "boot_time.h"
+#include "clock.h"
+#include "fault.h"
 #include "kernel.h"
 #include "printk.h"
 #include "uart.h"
 #include "timer.h"
 
 #define UART_BAUD_RATE 115200
+#define SYSCLK_FREQUENCY_HZ CLOCK_SYSCLK_MAX_HZ
 
 int kernel_main( void ) {
 
@@ -32,8 +36,14 @@ int kernel_main( void ) {
   static const int SYSTICK_FREQUENCY_HZ = 1000;
 
   init_349(); // DO NOT REMOVE THIS LINE
+  boot_time_mark( BOOT_MARK_INIT_349 );
+  clock_init( SYSCLK_FREQUENCY_HZ );
+  boot_time_mark( BOOT_MARK_CLOCK );
   uart_init( UART_BAUD_RATE );
+  boot_time_mark( BOOT_MARK_UART );
+  fault_report();
   timer_start(SYSTICK_FREQUENCY_HZ);
+  boot_time_mark( BOOT_MARK_TIMER );
   printk("Kernel Initialized, entering user mode.\n"); //sudo minicom -D /dev/serial/by-id/[tab] -b 115200
   enter_user_mode();
   return 0;
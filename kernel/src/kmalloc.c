@@ -27,8 +27,6 @@
 #include <debug.h>
 #include <unistd.h>
 
-#define UNUSED __attribute__((unused))
-
 /**
  * @brief      Initiliazes the kmalloc structure.
  *
@@ -42,12 +40,17 @@
  *
  * @return     Returns 0 if allocation was successful, or -1 otherwise.
  */
-void k_malloc_init( UNUSED kmalloc_t* internals,
-                    UNUSED char* heap_low,
-                    UNUSED char* heap_top,
-                    UNUSED uint32_t stack_size,
-                    UNUSED uint32_t unaligned ){
-
+void k_malloc_init( kmalloc_t* internals,
+                    char* heap_low,
+                    char* heap_top,
+                    uint32_t stack_size,
+                    uint32_t unaligned ){
+  internals->free_node = NULL;
+  internals->heap_low = heap_low;
+  internals->heap_top = heap_top;
+  internals->brk = heap_low;
+  internals->stack_size = stack_size;
+  internals->unaligned = unaligned;
 }
 
 /**
@@ -60,9 +63,19 @@ void k_malloc_init( UNUSED kmalloc_t* internals,
  *
  * @return     Returns the pointer to the allocated buffer.
  */
-void* k_malloc_unaligned( UNUSED kmalloc_t* internals,
-                          UNUSED uint32_t size ){
-  return NULL;
+void* k_malloc_unaligned( kmalloc_t* internals,
+                          uint32_t size ){
+  ASSERT( internals->unaligned );
+
+  // Keep every allocation word aligned.
+  size = ( size + sizeof( uint32_t ) - 1 ) & ~( sizeof( uint32_t ) - 1 );
+  if ( size > ( uint32_t )( internals->heap_top - internals->brk ) ) {
+    return NULL;
+  }
+
+  void *buffer = internals->brk;
+  internals->brk += size;
+  return buffer;
 }
 
 /**
@@ -72,8 +85,22 @@ void* k_malloc_unaligned( UNUSED kmalloc_t* internals,
  *
  * @return     Pointer to allocated buffer, can be NULL.
  */
-void* k_malloc_aligned( UNUSED kmalloc_t* internals ){
-  return NULL;
+void* k_malloc_aligned( kmalloc_t* internals ){
+  if ( internals->free_node ) {
+    list_node *node = internals->free_node;
+    internals->free_node = node->next;
+    return node;
+  }
+
+  // Regions are aligned to their size so they can back an MPU region.
+  uintptr_t size = internals->stack_size;
+  char *buffer = ( char * )( ( ( uintptr_t )internals->brk + size - 1 ) & ~( size - 1 ) );
+  if ( buffer > internals->heap_top || size > ( uintptr_t )( internals->heap_top - buffer ) ) {
+    return NULL;
+  }
+
+  internals->brk = buffer + size;
+  return buffer;
 }
 
 /**
@@ -87,6 +114,9 @@ void* k_malloc_aligned( UNUSED kmalloc_t* internals ){
  *             the buffer as a stack it must be the orignial pointer you
  *             obtained and not the current stack position.
  */
-void k_free( UNUSED kmalloc_t* internals, UNUSED void* buffer ){
+void k_free( kmalloc_t* internals, void* buffer ){
+  list_node *node = ( list_node * )buffer;
 
+  node->next = internals->free_node;
+  internals->free_node = node;
 }
@@ -43,27 +43,6 @@ typedef struct {
   //@}
 } mpu_t;
 
-/**
- * @struct system_control_block_t
- * @brief  System control block register layout.
- */
-typedef struct {
-  /**@brief System handler control and state register.*/
-  volatile uint32_t SHCRS;
-  /**@brief Configurable fault status register.*/
-  volatile uint32_t CFSR;
-  /**@brief HardFault Status Register */
-  volatile uint32_t HFSR;
-  /**@brief Hint information of debug events.*/
-  volatile uint32_t DFSR;
-  /**@brief Addr value of memfault*/
-  volatile uint32_t MMFAR;
-  /**@brief Addr of bus fault */
-  volatile uint32_t BFAR;
-  /**@brief Auxilliary fault status register.*/
-  volatile uint32_t AFSR;
-} system_control_block_t;
-
 /**@brief MPU base address.*/
 #define MPU_BASE ( ( mpu_t * )0xE000ED90 );
 
@@ -99,50 +78,6 @@ typedef struct {
 #define RASR_AP_USER_READ_WRITE ( 0b11<<24 )
 //@}
 
-/**@brief Systen control block MMIO location.*/
-#define SCB_BASE ( ( volatile system_control_block_t * )0xE000ED24 )
-
-/**@brief Stacking error.*/
-#define MSTKERR 0x1 << 4
-/**@brief Unstacking error.*/
-#define MUNSTKERR 0x1 << 3
-/**@brief Data access error.*/
-#define DACCVIOL 0x1 << 1
-/**@brief Instruction access error.*/
-#define IACCVIOL 0x1 << 0
-/**@brief Indicates the MMFAR is valid.*/
-#define MMARVALID 0x1 << 7
-
-void mm_c_handler( void *psp ) {
-
-  system_control_block_t *scb = ( system_control_block_t * )SCB_BASE;
-  int status = scb->CFSR & 0xFF;
-
-  // Attempt to print cause of fault
-  DEBUG_PRINT( "Memory Protection Fault\n" );
-  WARN( !( status & MSTKERR ), "Stacking Error\n" );
-  WARN( !( status & MUNSTKERR ), "Unstacking Error\n" );
-  WARN( !( status & DACCVIOL ), "Data access violation\n" );
-  WARN( !( status & IACCVIOL ), "Instruction access violation\n" );
-  WARN( !( status & MMARVALID ), "Faulting Address = %x\n", scb->MMFAR );
-
-  // You cannot recover from stack overflow because the processor has
-  // already pushed the exception context onto the stack, potentially
-  // clobbering whatever is in the adjacent stack.
-  if ( 0/* TODO: insert condition for stack overflow here */ ) {
-    DEBUG_PRINT( "Stack Overflow, aborting\n" );
-    sys_exit( -1 );
-  }
-
-  // Other errors can be recovered from by killing the offending
-  // thread. Standard thread killing rules apply. You should halt
-  // if the thread is the main or idle thread!
-  
-  // TODO: You decide how to kill the thread.
-  // Set the pc? Call a syscall? Context swap?
-  (void) psp;
-}
-
 /**
  * @brief  Enables a memory protection region. Regions must be aligned!
  *
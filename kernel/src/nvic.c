@@ -35,4 +35,10 @@ void nvic_clear_pending( uint8_t irq_num ) {
   struct nvic_t *nvic = NVIC_ICPR_BASE;
 
   nvic->reg[reg_num] |= ( 0x1 << shift_num );
+}
+
+void nvic_set_priority( uint8_t irq_num, uint8_t priority ) {
+  volatile uint8_t *ipr = NVIC_IPR_BASE;
+
+  ipr[irq_num] = ( uint8_t )( priority << NVIC_PRIO_SHIFT );
 }
\ No newline at end of file
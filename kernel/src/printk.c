@@ -9,14 +9,15 @@
 
 #include <unistd.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <uart_polling.h>
 #include <uart.h>
 
 
 /**
- * allows for numbers with 64 digits/letters
+ * allows for numbers with 32 digits/letters
  */
-#define MAXBUF (sizeof(uint32_t))
+#define MAXBUF (sizeof(uint32_t) * 8)
 
 /**
  * static array of digits for use in printnum(s)
@@ -107,7 +108,7 @@ int printk(const char *fmt, ...) {
       }
 
       case 's': { // string
-        int8_t *byte_ptr = (int8_t *)va_arg(args, int32_t);
+        int8_t *byte_ptr = va_arg(args, int8_t *);
         while (*byte_ptr) {
           uart_put_byte(*byte_ptr);
           byte_ptr++;
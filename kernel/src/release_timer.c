@@ -0,0 +1,126 @@
+/** @file release_timer.c
+ *
+ *  @brief  TIM5 one-shot release timer, see release_timer.h.
+ */
+
+#include <arm.h>
+#include <clock.h>
+#include <nvic.h>
+#include <rcc.h>
+#include <release_timer.h>
+#include <syscall_thread.h>
+
+/** @brief The general-purpose timer register map, up to CCR1. */
+struct tim_reg_map {
+  volatile uint32_t CR1;   /**< 00 - Control 1 */
+  volatile uint32_t CR2;   /**< 04 - Control 2 */
+  volatile uint32_t SMCR;  /**< 08 - Slave mode control */
+  volatile uint32_t DIER;  /**< 0C - DMA/interrupt enable */
+  volatile uint32_t SR;    /**< 10 - Status */
+  volatile uint32_t EGR;   /**< 14 - Event generation */
+  volatile uint32_t CCMR1; /**< 18 - Capture/compare mode 1 */
+  volatile uint32_t CCMR2; /**< 1C - Capture/compare mode 2 */
+  volatile uint32_t CCER;  /**< 20 - Capture/compare enable */
+  volatile uint32_t CNT;   /**< 24 - Counter */
+  volatile uint32_t PSC;   /**< 28 - Prescaler */
+  volatile uint32_t ARR;   /**< 2C - Auto-reload */
+  volatile uint32_t RCR;   /**< 30 - Unused on TIM5 */
+  volatile uint32_t CCR1;  /**< 34 - Capture/compare 1 */
+};
+
+/** @brief Base address of TIM5 */
+#define TIM5_BASE ( struct tim_reg_map * )0x40000C00
+
+/** @brief TIM5 clock enable in RCC APB1ENR */
+#define RCC_APB1ENR_TIM5EN ( 1 << 3 )
+
+/** @brief TIM5 interrupt number */
+#define TIM5_IRQ 50
+
+/** @brief Priority of the compare interrupt, that of SysTick and PendSV. */
+#define TIM5_IRQ_PRIORITY 1
+
+/** @brief Register bits */
+//@{
+#define TIM_CR1_CEN ( 1 << 0 )
+#define TIM_DIER_CC1IE ( 1 << 1 )
+#define TIM_SR_CC1IF ( 1 << 1 )
+#define TIM_EGR_UG ( 1 << 0 )
+#define TIM_EGR_CC1G ( 1 << 1 )
+//@}
+
+/**
+ * @brief      Clock the APB1 timers run at: PCLK1, doubled whenever APB1 is
+ *             divided down from HCLK.
+ */
+static uint32_t tim_clock_hz( void ) {
+  uint32_t pclk1 = clock_get_pclk1_hz();
+
+  return pclk1 == clock_get_hclk_hz() ? pclk1 : 2 * pclk1;
+}
+
+int release_timer_start( void ) {
+  struct rcc_reg_map *rcc = RCC_BASE;
+  struct tim_reg_map *tim = TIM5_BASE;
+  uint32_t clock_hz = tim_clock_hz();
+
+  if ( clock_hz % RELEASE_TIMER_HZ ) {
+    return -1;
+  }
+
+  rcc->apb1_enr |= RCC_APB1ENR_TIM5EN;
+
+  tim->CR1 = 0;
+  tim->DIER = 0;
+  tim->PSC = clock_hz / RELEASE_TIMER_HZ - 1;
+  tim->ARR = 0xFFFFFFFF;
+  // The prescaler is buffered until an update event, which also clears CNT.
+  tim->EGR = TIM_EGR_UG;
+  tim->SR = 0;
+
+  nvic_set_priority( TIM5_IRQ, TIM5_IRQ_PRIORITY );
+  nvic_clear_pending( TIM5_IRQ );
+  nvic_irq( TIM5_IRQ, IRQ_ENABLE );
+
+  tim->CR1 = TIM_CR1_CEN;
+  return 0;
+}
+
+void release_timer_stop( void ) {
+  struct tim_reg_map *tim = TIM5_BASE;
+
+  tim->CR1 = 0;
+  tim->DIER = 0;
+  nvic_irq( TIM5_IRQ, IRQ_DISABLE );
+  nvic_clear_pending( TIM5_IRQ );
+}
+
+uint32_t release_timer_now( void ) {
+  return ( TIM5_BASE )->CNT;
+}
+
+void release_timer_arm( uint32_t at ) {
+  struct tim_reg_map *tim = TIM5_BASE;
+
+  tim->CCR1 = at;
+  tim->SR = ~TIM_SR_CC1IF;
+  tim->DIER = TIM_DIER_CC1IE;
+  // The match only fires when CNT passes CCR1, so a missed instant is forced.
+  if ( ( int32_t )( at - tim->CNT ) <= 0 ) {
+    tim->EGR = TIM_EGR_CC1G;
+  }
+}
+
+void release_timer_cancel( void ) {
+  struct tim_reg_map *tim = TIM5_BASE;
+
+  tim->DIER = 0;
+  tim->SR = ~TIM_SR_CC1IF;
+}
+
+RAMFUNC void release_timer_irq_handler( void ) {
+  cpu_isr_enter();
+  release_timer_cancel();
+  sched_release_timer();
+  cpu_isr_exit();
+}
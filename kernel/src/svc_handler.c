@@ -4,249 +4,472 @@
  * @brief Contains the C-portion of the SVC handler.
  * @version 0.1
  * @date 2024-02-14
- * 
+ *
  * @copyright Copyright (c) 2024
- * 
+ *
  */
 
 #include <stdint.h>
+#include <arm.h>
 #include <debug.h>
 #include <svc_num.h>
 #include <syscall.h>
-
-#define UNUSED __attribute__((unused))
+#include <syscall_thread.h>
+#include <syscall_mutex.h>
+#include <syscall_sync.h>
+#include <syscall_timer.h>
+#include <svc_batch.h>
+#include <svc_stats.h>
+#include <irq_latency.h>
 
 /**
- * @brief Calls the system call that corresponds with the SVC number found
- * within the SVC instruction that was run (found at an offset from the address
- * of the top of the process stack == psp_top_address.)
- * 
- * @param psp_top_address The address of the top of the process stack == the
- * address of the item that as most recently pushed to the process stack.
- * 
- * @note Lecture 4, Slide 75 gives some pretty comprehensive starter code here
- * to reference.
- * 
+ * @brief Define a struct "stack frame" that specifies/defines what fields we
+ * will find pushed to the stack according to the APPCS calling convention
+ * for Armv7-m. r0 will be at the beginning of the stack frame (first address)
+ * and the xPSR will be at the end. If the syscall made required more than
+ * four arguments (placed in r0-->r3), then they will be found in the stack
+ * immediately after the last element of the pushed stack frame (so after the
+ * xPSR register(s)).
+ *
+ * @note The exact structure of this stack frame can be found in section 2.3.7
+ * of the generic m4 manual. STKALIGN is off, so there is never a padding word
+ * between the frame and the fifth argument.
+ *
  */
-void svc_c_handler(UNUSED uint32_t *psp_top_address) {
-
-  /**
-   * @brief Define a struct "stack frame" that specifies/defines what fields we
-   * will find pushed to the stack according to the APPCS calling convention
-   * for Armv7-m. r0 will be at the beginning of the stack frame (first address)
-   * and the xPSR will be at the end. If the syscall made required more than
-   * four arguments (placed in r0-->r3), then they will be found in the stack
-   * immediately after the last element of the pushed stack frame (so after the
-   * xPSR register(s)).
-   * 
-   * @note the xPSR is really just a SINGLE 32-bit register, but where different
-   * portions of the 32-bit field correspond to different "sub-fields" (I.e.,
-   * the APSR, IPSR, and EPSR).
-   * 
-   * @note The exact structure of this stack frame can be found in section 2.3.7
-   * of the generic m4 manual.
-   * 
-   */
-  typedef struct {
-    uint32_t r0;
-    uint32_t r1;
-    uint32_t r2;
-    uint32_t r3;
-    uint32_t r12;
-    uint32_t lr;
-    uint32_t pc;
-    uint32_t xpsr;
-  } stack_frame_t;
-
-  /**
-   * @brief Create a wrapper around the frame in the stack that came from the
-   * context that made the system call in the first place. This is where we will
-   * find the arguments provided for the syscall function.
-   * 
-   */
-  stack_frame_t *caller_frame = (stack_frame_t *)psp_top_address;
-
-  /**
-   * @brief 1.) Load the SVC instruction word from flash memory. How? We know
-   * that for Armv7-m, when the SVC instruction is being decoded, the PC will
-   * hold the address of the instruction that follows the SVC instruction. This
-   * PC value is what will get pushed to the stack along with the values of all
-   * the other registers from the caller context.
-   * 
-   * @note Pointer arithmetic here: move back the address by one half-word (so
-   * subtract 2 byte addresses).
-   * 
-   * @note The SVC instruction is only a 16-bit instruction!
-   * 
-   */
-  uint16_t svc_instruction = *((uint16_t *)(caller_frame->pc) - 1);
-  
-  /**
-   * @brief Then, extract the SVC number from the bottom eight bits of the SVC
-   * instruction.
-   * 
-   */
-  uint8_t svc_number = (uint8_t)(svc_instruction & 0x00FF);
-
-  // __asm volatile( "bkpt" );
-
-  /**
-   * @brief Now, call the sycall C function that corresponds with the extracted
-   * SVC numbber.
-   * 
-   * @todo Need to determine what we need to do with the syscall return code.
-   * Check the handout.
-   * 
-   */
-
-  switch ( svc_number ) {
-
-    case (uint8_t)SVC_SBRK: {
-
-      /**
-       * @brief The argument for sys_sbrk will be in the first register of the
-       * caller frame.
-       * 
-       */
-      typedef struct {
-        int increment;
-      } sys_sbrk_args_t;
-
-      sys_sbrk_args_t *sys_sbrk_args = (sys_sbrk_args_t *)caller_frame;
-      
-      void *return_value = sys_sbrk(sys_sbrk_args->increment);
-
-      /**
-       * @brief Set the return value r0 by setting its value in the process
-       * stack--that way, when it gets restored/pushed back into the registers,
-       * the return value will ultimately end up in r0 where the caller function
-       * is expecting it.
-       * 
-       */
-      caller_frame->r0 = (uint32_t)return_value;
-
-      break;
+typedef struct {
+  uint32_t r0;
+  uint32_t r1;
+  uint32_t r2;
+  uint32_t r3;
+  uint32_t r12;
+  uint32_t lr;
+  uint32_t pc;
+  uint32_t xpsr;
+  uint32_t arg4;
+} stack_frame_t;
 
-    }
-
-    case (uint8_t)SVC_WRITE: {
-
-      /**
-       * @brief The arguments for sys_write will be in the first three registers
-       * of the caller frame, with the first argument being placed in r0. We
-       * will refer to the items on the stack via this struct type. This just
-       * gives us a safe, structured, and clear way of accessing our syscall's
-       * arguments in the stack frame.
-       * 
-       */
-      typedef struct {
-        int file;
-        char *buffer;
-        int num_bytes;
-      } sys_write_args_t;
-
-      sys_write_args_t *sys_write_args = (sys_write_args_t *)caller_frame;
-
-      int return_value = sys_write(sys_write_args->file, sys_write_args->buffer, sys_write_args->num_bytes);
-
-      /**
-       * @brief Set the return value r0 by setting its value in the process
-       * stack--that way, when it gets restored/pushed back into the registers,
-       * the return value will ultimately end up in r0 where the caller function
-       * is expecting it.
-       * 
-       */
-      caller_frame->r0 = (uint32_t)return_value;
-      
-      break;
+/**
+ * @brief Every syscall is called through the same signature: the caller's r0
+ * to r3 and its fifth argument. The return value goes back in r0, which the
+ * caller treats as clobbered even for void syscalls.
+ *
+ */
+typedef uint32_t (*svc_fn_t)(uint32_t arg0, uint32_t arg1, uint32_t arg2,
+                             uint32_t arg3, uint32_t arg4);
 
-    }
+/**
+ * @brief Adapters from the uniform signature to each sys_* function.
+ *
+ */
+//@{
+static uint32_t svc_sbrk(uint32_t incr, uint32_t a1, uint32_t a2, uint32_t a3,
+                         uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_sbrk((int)incr);
+}
+
+static uint32_t svc_write(uint32_t file, uint32_t ptr, uint32_t len,
+                          uint32_t a3, uint32_t a4) {
+  (void) a3; (void) a4;
+  return (uint32_t)sys_write((int)file, (char *)ptr, (int)len);
+}
+
+static uint32_t svc_read(uint32_t file, uint32_t ptr, uint32_t len,
+                         uint32_t a3, uint32_t a4) {
+  (void) a3; (void) a4;
+  return (uint32_t)sys_read((int)file, (char *)ptr, (int)len);
+}
+
+static uint32_t svc_fstat(uint32_t file, uint32_t st, uint32_t a2,
+                          uint32_t a3, uint32_t a4) {
+  (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_fstat((int)file, (struct stat *)st);
+}
+
+static uint32_t svc_isatty(uint32_t file, uint32_t a1, uint32_t a2,
+                           uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_isatty((int)file);
+}
+
+static uint32_t svc_lseek(uint32_t file, uint32_t ptr, uint32_t dir,
+                          uint32_t a3, uint32_t a4) {
+  (void) a3; (void) a4;
+  return (uint32_t)sys_lseek((int)file, (int)ptr, (int)dir);
+}
+
+static uint32_t svc_exit(uint32_t status, uint32_t a1, uint32_t a2,
+                         uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  sys_exit((int)status);
+  return 0;
+}
+
+static uint32_t svc_thread_init(uint32_t max_threads, uint32_t stack_size,
+                                uint32_t idle_fn, uint32_t memory_protection,
+                                uint32_t max_mutexes) {
+  return (uint32_t)sys_thread_init(max_threads, stack_size, (void *)idle_fn,
+                                   (protection_mode)memory_protection,
+                                   max_mutexes);
+}
+
+static uint32_t svc_thread_create(uint32_t fn, uint32_t prio, uint32_t C,
+                                  uint32_t T, uint32_t vargp) {
+  return (uint32_t)sys_thread_create((void *)fn, prio, C, T, (void *)vargp);
+}
+
+static uint32_t svc_thread_kill(uint32_t a0, uint32_t a1, uint32_t a2,
+                                uint32_t a3, uint32_t a4) {
+  (void) a0; (void) a1; (void) a2; (void) a3; (void) a4;
+  sys_thread_kill();
+  return 0;
+}
+
+static uint32_t svc_get_pid(uint32_t a0, uint32_t a1, uint32_t a2,
+                            uint32_t a3, uint32_t a4) {
+  (void) a0; (void) a1; (void) a2; (void) a3; (void) a4;
+  return sys_get_pid();
+}
+
+static uint32_t svc_mutex_init(uint32_t max_prio, uint32_t a1, uint32_t a2,
+                               uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_mutex_init(max_prio);
+}
+
+static uint32_t svc_mutex_lock(uint32_t mutex, uint32_t a1, uint32_t a2,
+                               uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  sys_mutex_lock((kmutex_t *)mutex);
+  return 0;
+}
+
+static uint32_t svc_mutex_unlock(uint32_t mutex, uint32_t a1, uint32_t a2,
+                                 uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  sys_mutex_unlock((kmutex_t *)mutex);
+  return 0;
+}
+
+static uint32_t svc_wait(uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3,
+                         uint32_t a4) {
+  (void) a0; (void) a1; (void) a2; (void) a3; (void) a4;
+  sys_wait_until_next_period();
+  return 0;
+}
+
+static uint32_t svc_sleep_till_int(uint32_t a0, uint32_t a1, uint32_t a2,
+                                   uint32_t a3, uint32_t a4) {
+  (void) a0; (void) a1; (void) a2; (void) a3; (void) a4;
+  sys_sleep_till_interrupt();
+  return 0;
+}
+
+static uint32_t svc_time(uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3,
+                         uint32_t a4) {
+  (void) a0; (void) a1; (void) a2; (void) a3; (void) a4;
+  return sys_get_time();
+}
+
+static uint32_t svc_scheduler_start(uint32_t frequency, uint32_t a1,
+                                    uint32_t a2, uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_scheduler_start(frequency);
+}
+
+static uint32_t svc_priority(uint32_t a0, uint32_t a1, uint32_t a2,
+                             uint32_t a3, uint32_t a4) {
+  (void) a0; (void) a1; (void) a2; (void) a3; (void) a4;
+  return sys_get_priority();
+}
+
+static uint32_t svc_thread_time(uint32_t a0, uint32_t a1, uint32_t a2,
+                                uint32_t a3, uint32_t a4) {
+  (void) a0; (void) a1; (void) a2; (void) a3; (void) a4;
+  return sys_thread_time();
+}
+
+static uint32_t svc_os_get_ticks(uint32_t a0, uint32_t a1, uint32_t a2,
+                                 uint32_t a3, uint32_t a4) {
+  (void) a0; (void) a1; (void) a2; (void) a3; (void) a4;
+  return sys_os_get_ticks();
+}
+
+static uint32_t svc_get_cycles(uint32_t a0, uint32_t a1, uint32_t a2,
+                               uint32_t a3, uint32_t a4) {
+  (void) a0; (void) a1; (void) a2; (void) a3; (void) a4;
+  return sys_get_cycles();
+}
+
+static uint32_t svc_get_time_us(uint32_t a0, uint32_t a1, uint32_t a2,
+                                uint32_t a3, uint32_t a4) {
+  (void) a0; (void) a1; (void) a2; (void) a3; (void) a4;
+  return sys_get_time_us();
+}
+
+static uint32_t svc_timer_create(uint32_t callback, uint32_t arg, uint32_t a2,
+                                 uint32_t a3, uint32_t a4) {
+  (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_timer_create((void *)callback, (void *)arg);
+}
+
+static uint32_t svc_timer_start(uint32_t timer, uint32_t delay,
+                                uint32_t period, uint32_t a3, uint32_t a4) {
+  (void) a3; (void) a4;
+  return (uint32_t)sys_timer_start((ktimer_t *)timer, delay, period);
+}
+
+static uint32_t svc_timer_stop(uint32_t timer, uint32_t a1, uint32_t a2,
+                               uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_timer_stop((ktimer_t *)timer);
+}
+
+static uint32_t svc_timer_wait(uint32_t arg, uint32_t a1, uint32_t a2,
+                               uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_timer_wait((void **)arg);
+}
+
+static uint32_t svc_cpu_stats(uint32_t stats, uint32_t a1, uint32_t a2,
+                              uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  return sys_cpu_stats((cpu_stats_t *)stats);
+}
+
+static uint32_t svc_stats_dump(uint32_t reset, uint32_t a1, uint32_t a2,
+                               uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_svc_stats_dump((int)reset);
+}
+
+static uint32_t svc_irq_latency_dump(uint32_t reset, uint32_t a1, uint32_t a2,
+                                     uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_irq_latency_dump((int)reset);
+}
+
+static uint32_t svc_futex_wait(uint32_t addr, uint32_t expected, uint32_t a2,
+                               uint32_t a3, uint32_t a4) {
+  (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_futex_wait((uint32_t *)addr, expected);
+}
+
+static uint32_t svc_futex_wake(uint32_t addr, uint32_t a1, uint32_t a2,
+                               uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  sys_futex_wake((uint32_t *)addr);
+  return 0;
+}
+
+static uint32_t svc_sem_init(uint32_t count, uint32_t a1, uint32_t a2,
+                             uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_sem_init(count);
+}
+
+static uint32_t svc_sem_wait(uint32_t sem, uint32_t timeout, uint32_t a2,
+                             uint32_t a3, uint32_t a4) {
+  (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_sem_wait((ksem_t *)sem, timeout);
+}
+
+static uint32_t svc_sem_post(uint32_t sem, uint32_t a1, uint32_t a2,
+                             uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
+  sys_sem_post((ksem_t *)sem);
+  return 0;
+}
+
+static uint32_t svc_event_init(uint32_t a0, uint32_t a1, uint32_t a2,
+                               uint32_t a3, uint32_t a4) {
+  (void) a0; (void) a1; (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_event_init();
+}
+
+static uint32_t svc_event_wait(uint32_t event, uint32_t mask, uint32_t options,
+                               uint32_t timeout, uint32_t a4) {
+  (void) a4;
+  return sys_event_wait((kevent_t *)event, mask, options, timeout);
+}
+
+static uint32_t svc_event_set(uint32_t event, uint32_t flags, uint32_t a2,
+                              uint32_t a3, uint32_t a4) {
+  (void) a2; (void) a3; (void) a4;
+  sys_event_set((kevent_t *)event, flags);
+  return 0;
+}
+
+static uint32_t svc_event_clear(uint32_t event, uint32_t flags, uint32_t a2,
+                                uint32_t a3, uint32_t a4) {
+  (void) a2; (void) a3; (void) a4;
+  sys_event_clear((kevent_t *)event, flags);
+  return 0;
+}
+
+static uint32_t svc_queue_init(uint32_t msg_size, uint32_t capacity,
+                               uint32_t a2, uint32_t a3, uint32_t a4) {
+  (void) a2; (void) a3; (void) a4;
+  return (uint32_t)sys_queue_init(msg_size, capacity);
+}
+
+static uint32_t svc_queue_send(uint32_t queue, uint32_t msg, uint32_t timeout,
+                               uint32_t a3, uint32_t a4) {
+  (void) a3; (void) a4;
+  return (uint32_t)sys_queue_send((kqueue_t *)queue, (const void *)msg, timeout);
+}
+
+static uint32_t svc_queue_recv(uint32_t queue, uint32_t msg, uint32_t timeout,
+                               uint32_t a3, uint32_t a4) {
+  (void) a3; (void) a4;
+  return (uint32_t)sys_queue_recv((kqueue_t *)queue, (void *)msg, timeout);
+}
+
+static uint32_t svc_mutex_stats(uint32_t mutex, uint32_t stats, uint32_t reset,
+                                uint32_t a3, uint32_t a4) {
+  (void) a3; (void) a4;
+  return (uint32_t)sys_mutex_stats((kmutex_t *)mutex, (mutex_stats_t *)stats,
+                                   (int)reset);
+}
+
+static uint32_t svc_thread_block_stats(uint32_t prio, uint32_t stats,
+                                       uint32_t reset, uint32_t a3,
+                                       uint32_t a4) {
+  (void) a3; (void) a4;
+  return (uint32_t)sys_thread_block_stats(prio, (thread_block_stats_t *)stats,
+                                          (int)reset);
+}
+
+static uint32_t svc_batch(uint32_t batch, uint32_t a1, uint32_t a2,
+                          uint32_t a3, uint32_t a4);
+//@}
 
-    case (uint8_t)SVC_READ: {
-      
-      /**
-       * @brief The arguments for sys_read will be in the first three registers
-       * of the caller frame, with the first argument being placed in r0. We
-       * will refer to the items on the stack via this struct type.
-       * 
-       */
-      typedef struct {
-        int file;
-        char *buffer;
-        int num_bytes;
-      } sys_read_args_t;
-
-      sys_read_args_t *sys_read_args = (sys_read_args_t *)caller_frame;
-
-      int return_value = sys_read(sys_read_args->file, sys_read_args->buffer, sys_read_args->num_bytes);
-
-      /**
-       * @brief Set the return value r0 by setting its value in the process
-       * stack--that way, when it gets restored/pushed back into the registers,
-       * the return value will ultimately end up in r0 where the caller function
-       * is expecting it.
-       * 
-       */
-      caller_frame->r0 = (uint32_t)return_value;
-
-      break;
+/**
+ * @brief Dispatch table indexed by SVC number. Unimplemented numbers are NULL.
+ * SVC_TIME and SVC_PRIORITY normally never get here, _svc_asm_handler_
+ * answers them itself.
+ *
+ */
+static const svc_fn_t svc_table[SVC_COUNT] = {
+  [SVC_SBRK]         = svc_sbrk,
+  [SVC_FSTAT]        = svc_fstat,
+  [SVC_ISATTY]       = svc_isatty,
+  [SVC_LSEEK]        = svc_lseek,
+  [SVC_WRITE]        = svc_write,
+  [SVC_READ]         = svc_read,
+  [SVC_EXIT]         = svc_exit,
+  [SVC_THR_INIT]     = svc_thread_init,
+  [SVC_THR_CREATE]   = svc_thread_create,
+  [SVC_THR_KILL]     = svc_thread_kill,
+  [SVC_GET_PID]      = svc_get_pid,
+  [SVC_MUT_INIT]     = svc_mutex_init,
+  [SVC_MUT_LOK]      = svc_mutex_lock,
+  [SVC_MUT_ULK]      = svc_mutex_unlock,
+  [SVC_WAIT]         = svc_wait,
+  [SVC_TIME]         = svc_time,
+  [SVC_SCHD_START]   = svc_scheduler_start,
+  [SVC_PRIORITY]     = svc_priority,
+  [SVC_THR_TIME]     = svc_thread_time,
+  [SVC_SLEEP_TILL_INT] = svc_sleep_till_int,
+  [SVC_OS_GET_TICKS] = svc_os_get_ticks,
+  [SVC_GET_CYCLES]   = svc_get_cycles,
+  [SVC_BATCH]        = svc_batch,
+  [SVC_STATS_DUMP]   = svc_stats_dump,
+  [SVC_FUTEX_WAIT]   = svc_futex_wait,
+  [SVC_FUTEX_WAKE]   = svc_futex_wake,
+  [SVC_SEM_INIT]     = svc_sem_init,
+  [SVC_SEM_WAIT]     = svc_sem_wait,
+  [SVC_SEM_POST]     = svc_sem_post,
+  [SVC_EVENT_INIT]   = svc_event_init,
+  [SVC_EVENT_WAIT]   = svc_event_wait,
+  [SVC_EVENT_SET]    = svc_event_set,
+  [SVC_EVENT_CLEAR]  = svc_event_clear,
+  [SVC_QUEUE_INIT]   = svc_queue_init,
+  [SVC_QUEUE_SEND]   = svc_queue_send,
+  [SVC_QUEUE_RECV]   = svc_queue_recv,
+  [SVC_MUT_STATS]    = svc_mutex_stats,
+  [SVC_THR_BLOCK_STATS] = svc_thread_block_stats,
+  [SVC_GET_TIME_US]  = svc_get_time_us,
+  [SVC_TIMER_CREATE] = svc_timer_create,
+  [SVC_TIMER_START]  = svc_timer_start,
+  [SVC_TIMER_STOP]   = svc_timer_stop,
+  [SVC_TIMER_WAIT]   = svc_timer_wait,
+  [SVC_CPU_STATS]    = svc_cpu_stats,
+  [SVC_IRQ_LATENCY_DUMP] = svc_irq_latency_dump,
+};
 
-    }
+/**
+ * @brief Calls one table entry, which must exist, and times it when built
+ * with SVC_STATS.
+ *
+ */
+static inline uint32_t svc_call(uint32_t svc_number, uint32_t arg0,
+                                uint32_t arg1, uint32_t arg2, uint32_t arg3,
+                                uint32_t arg4) {
+  uint32_t start = svc_stats_begin();
+  uint32_t result = svc_table[svc_number](arg0, arg1, arg2, arg3, arg4);
 
-    case (uint8_t)SVC_EXIT: {
+  svc_stats_record(svc_number, start);
+  return result;
+}
 
-      /**
-       * @brief The argument for sys_exit will be in the first register of the
-       * caller frame.
-       * 
-       */
-      typedef struct {
-        int status;
-      } sys_exit_args_t;
+/**
+ * @brief Runs every call queued in a svc_batch_t through the table, so a
+ * thread pays for one exception instead of one per call. See svc_batch.h.
+ *
+ * @return The number of calls run.
+ *
+ */
+static uint32_t svc_batch(uint32_t batch, uint32_t a1, uint32_t a2,
+                          uint32_t a3, uint32_t a4) {
+  (void) a1; (void) a2; (void) a3; (void) a4;
 
-      sys_exit_args_t *sys_exit_args = (sys_exit_args_t *)caller_frame;
-      
-      sys_exit(sys_exit_args->status);
+  svc_batch_t *b = (svc_batch_t *)batch;
+  uint32_t count = b->count < SVC_BATCH_MAX ? b->count : SVC_BATCH_MAX;
 
-      /**
-       * @brief sys_exit does not have a return value, so nothing to do here.
-       * 
-       */
-      break;
+  for (uint32_t i = 0; i < count; i++) {
+    svc_sqe_t *sqe = &b->sq[i];
 
+    // A nested batch would recurse on the kernel stack.
+    if (sqe->svc_num >= SVC_COUNT || sqe->svc_num == SVC_BATCH ||
+        !svc_table[sqe->svc_num]) {
+      b->cq[i] = SVC_BATCH_EINVAL;
+      continue;
     }
+    b->cq[i] = svc_call(sqe->svc_num, sqe->args[0], sqe->args[1],
+                        sqe->args[2], sqe->args[3], sqe->args[4]);
+  }
 
-    case (uint8_t)SVC_OS_GET_TICKS: {
-
-      /**
-       * @brief os_get_ticks is not called with any arguments, so just call it
-       * here.
-       * 
-       */
-      uint32_t return_value = sys_os_get_ticks();
-
-      /**
-       * @brief Set the return value r0 by setting its value in the process
-       * stack--that way, when it gets restored/pushed back into the registers,
-       * the return value will ultimately end up in r0 where the caller function
-       * is expecting it.
-       * 
-       */
-      caller_frame->r0 = (uint32_t)return_value;
+  return count;
+}
 
-      break;
+/**
+ * @brief Calls the system call that corresponds with the SVC number, which
+ * _svc_asm_handler_ has already decoded from the SVC instruction.
+ *
+ * @param psp_top_address The address of the top of the process stack == the
+ * address of the item that as most recently pushed to the process stack.
+ * @param svc_number The immediate of the SVC instruction.
+ *
+ */
+RAMFUNC void svc_c_handler(uint32_t *psp_top_address, uint32_t svc_number) {
 
-    }
+  stack_frame_t *caller_frame = (stack_frame_t *)psp_top_address;
 
-    default: {
-      DEBUG_PRINT( "Not implemented, svc num %d\n", svc_number);
-      // ASSERT( 0 );
-    }
+  if (svc_number >= SVC_COUNT || !svc_table[svc_number]) {
+    DEBUG_PRINT( "Not implemented, svc num %d\n", (int)svc_number);
+    return;
   }
 
   /**
-   * @note The return value of this function gets set in whichever case is
-   * executed.
+   * @brief Set the return value r0 by setting its value in the process
+   * stack--that way, when it gets restored/pushed back into the registers,
+   * the return value will ultimately end up in r0 where the caller function
+   * is expecting it.
+   *
    */
+  caller_frame->r0 = svc_call(svc_number, caller_frame->r0, caller_frame->r1,
+                              caller_frame->r2, caller_frame->r3,
+                              caller_frame->arg4);
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,63 @@
+/** @file svc_stats.c
+ *
+ *  @brief  Per-SVC call counts and latency histograms, see svc_stats.h.
+ */
+
+#include <arm.h>
+#include <kstring.h>
+#include <printk.h>
+#include <svc_stats.h>
+
+#ifdef SVC_STATS
+
+svc_stats_t svc_stats[ SVC_COUNT ];
+
+void svc_stats_record( uint32_t svc_number, uint32_t start ) {
+  uint32_t cycles = dwt_get_cycles() - start;
+  uint32_t bucket = cycles ? 32 - __builtin_clz( cycles ) : 0;
+  svc_stats_t *stats = &svc_stats[ svc_number ];
+
+  if ( bucket >= SVC_STATS_BUCKETS ) {
+    bucket = SVC_STATS_BUCKETS - 1;
+  }
+
+  // A thread switch inside a call lets another thread record in between.
+  int state = save_interrupt_state_and_disable();
+  stats->count++;
+  stats->cycles += cycles;
+  stats->buckets[ bucket ]++;
+  restore_interrupt_state( state );
+}
+
+int sys_svc_stats_dump( int reset ) {
+  printk( "svc,calls,avg_cycles,buckets\n" );
+  for ( int i = 0; i < SVC_COUNT; i++ ) {
+    svc_stats_t *stats = &svc_stats[ i ];
+
+    if ( !stats->count ) {
+      continue;
+    }
+    printk( "%d,%u,%u,", i, stats->count,
+            ( uint32_t )( stats->cycles / stats->count ) );
+    for ( int b = 0; b < SVC_STATS_BUCKETS; b++ ) {
+      printk( b ? " %u" : "%u", stats->buckets[ b ] );
+    }
+    printk( "\n" );
+  }
+
+  if ( reset ) {
+    int state = save_interrupt_state_and_disable();
+    k_memset( svc_stats, 0, sizeof( svc_stats ) );
+    restore_interrupt_state( state );
+  }
+  return 0;
+}
+
+#else
+
+int sys_svc_stats_dump( int reset ) {
+  ( void )reset;
+  return -1;
+}
+
+#endif /* SVC_STATS */
@@ -9,10 +9,12 @@
  */
 
 #include <unistd.h>
+#include <kstring.h>
 #include <syscall.h>
 #include <printk.h>
 #include <uart.h>
 #include <timer.h>
+#include <dwt.h>
 
 #define UNUSED __attribute__((unused))
 // the following macro is for IO read and write
@@ -140,6 +142,37 @@ void sys_exit(UNUSED int status){
   return;
 }
 
+/**
+ * @brief All three standard streams are the UART.
+ * 
+ */
+static int is_uart(int file) {
+  return file >= 0 && file <= 2;
+}
+
+int sys_fstat(int file, struct stat *st){
+  if (!is_uart(file)) {
+    return -1;
+  }
+
+  /**
+   * @brief newlib only looks at st_mode and st_blksize. Leaving st_blksize 0
+   * gets it BUFSIZ, crt0 normally sets its own buffer before main anyway.
+   * 
+   */
+  k_memset(st, 0, sizeof(*st));
+  st->st_mode = S_IFCHR;
+  return 0;
+}
+
+int sys_isatty(int file){
+  return is_uart(file);
+}
+
+int sys_lseek(UNUSED int file, UNUSED int ptr, UNUSED int dir){
+  return -1;
+}
+
 uint32_t sys_os_get_ticks() {
 
   /**
@@ -149,4 +182,12 @@ uint32_t sys_os_get_ticks() {
    */
   return systick_get_millis();
 
-}
\ No newline at end of file
+}
+
+uint32_t sys_get_cycles() {
+  return dwt_get_cycles();
+}
+
+uint32_t sys_get_time_us() {
+  return ( uint32_t )timer_get_us();
+}
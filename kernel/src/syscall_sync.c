@@ -0,0 +1,287 @@
+/** @file   syscall_sync.c
+ *
+ *  @brief  Semaphores, event flag groups and message queues, see
+ *          syscall_sync.h.
+ *
+ *          Wakers hand results straight to the sleeper through the record it
+ *          gave sched_sleep(), a token, its flags or its message, so a woken
+ *          thread never has to retry and lose to one that ran first.
+ */
+
+#include <stdint.h>
+#include <kstring.h>
+#include "arm.h"
+#include "syscall_sync.h"
+#include "syscall_thread.h"
+
+/**
+ * @brief      What a thread sleeping in sys_event_wait() waits for, and the
+ *             flags it got.
+ */
+typedef struct {
+  uint32_t mask;
+  uint32_t options;
+  uint32_t result;
+} event_waiter_t;
+
+/** @brief      Objects handed out by the init calls. */
+//@{
+static ksem_t sems[ MAX_SEMAPHORES ];
+static uint32_t sem_count;
+static kevent_t events[ MAX_EVENT_GROUPS ];
+static uint32_t event_count;
+static kqueue_t queues[ MAX_MSG_QUEUES ];
+static uint32_t queue_count;
+//@}
+
+/** @brief      Message buffers, allocated from the bottom up. */
+//@{
+static uint8_t queue_pool[ MSG_QUEUE_POOL_SIZE ] __attribute__( ( aligned( 4 ) ) );
+static uint32_t queue_pool_used;
+//@}
+
+/**
+ * @brief      Whether obj is one of the first count objects of size bytes in
+ *             pool. Handles come from user mode and anything else could point
+ *             anywhere in the kernel.
+ */
+static int in_pool( const void *obj, const void *pool, uint32_t count, uint32_t size ) {
+  uintptr_t offset = ( uintptr_t )obj - ( uintptr_t )pool;
+
+  return offset < count * size && offset % size == 0;
+}
+
+/** @brief      Whether a handle is a semaphore, group or queue handed out. */
+//@{
+#define IS_SEM( sem ) in_pool( sem, sems, sem_count, sizeof( ksem_t ) )
+#define IS_EVENT( event ) in_pool( event, events, event_count, sizeof( kevent_t ) )
+#define IS_QUEUE( queue ) in_pool( queue, queues, queue_count, sizeof( kqueue_t ) )
+//@}
+
+/**
+ * @brief      The flags in mask that satisfy a wait, 0 if it must go on.
+ */
+static uint32_t event_match( uint32_t flags, uint32_t mask, uint32_t options ) {
+  uint32_t matched = flags & mask;
+
+  if ( options & EVENT_WAIT_ALL ) {
+    return matched == mask ? matched : 0;
+  }
+  return matched;
+}
+
+/**
+ * @brief      The slot of the message count positions after the head.
+ */
+static uint8_t *queue_slot( kqueue_t *queue, uint32_t position ) {
+  uint32_t slot = queue->head + position;
+
+  if ( slot >= queue->capacity ) {
+    slot -= queue->capacity;
+  }
+  return queue->buffer + slot * queue->msg_size;
+}
+
+void sync_reset( void ) {
+  sem_count = 0;
+  event_count = 0;
+  queue_count = 0;
+  queue_pool_used = 0;
+}
+
+ksem_t *sys_sem_init( uint32_t count ) {
+  if ( sem_count >= MAX_SEMAPHORES ) {
+    return NULL;
+  }
+
+  ksem_t *sem = &sems[ sem_count++ ];
+
+  sem->count = count;
+  sem->waiters = 0;
+  return sem;
+}
+
+int sys_sem_wait( ksem_t *sem, uint32_t timeout ) {
+  if ( !IS_SEM( sem ) ) {
+    return -1;
+  }
+
+  int state = save_interrupt_state_and_disable();
+  int result = 0;
+
+  if ( sem->count ) {
+    sem->count--;
+  } else {
+    // sys_sem_post() hands the token over without counting it.
+    result = sched_sleep( &sem->waiters, NULL, timeout, &state );
+  }
+  restore_interrupt_state( state );
+  return result;
+}
+
+void sys_sem_post( ksem_t *sem ) {
+  if ( !IS_SEM( sem ) ) {
+    return;
+  }
+
+  int state = save_interrupt_state_and_disable();
+
+  if ( sem->waiters ) {
+    sched_wake( &sem->waiters, __builtin_ctz( sem->waiters ) );
+  } else {
+    sem->count++;
+  }
+  restore_interrupt_state( state );
+}
+
+kevent_t *sys_event_init( void ) {
+  if ( event_count >= MAX_EVENT_GROUPS ) {
+    return NULL;
+  }
+
+  kevent_t *event = &events[ event_count++ ];
+
+  event->flags = 0;
+  event->waiters = 0;
+  return event;
+}
+
+uint32_t sys_event_wait( kevent_t *event, uint32_t mask, uint32_t options,
+                         uint32_t timeout ) {
+  if ( mask == 0 || !IS_EVENT( event ) ) {
+    return 0;
+  }
+
+  int state = save_interrupt_state_and_disable();
+  event_waiter_t waiter = {
+    .mask = mask,
+    .options = options,
+    .result = event_match( event->flags, mask, options )
+  };
+
+  if ( waiter.result ) {
+    if ( options & EVENT_CLEAR ) {
+      event->flags &= ~waiter.result;
+    }
+  } else if ( sched_sleep( &event->waiters, &waiter, timeout, &state ) ) {
+    waiter.result = 0;
+  }
+  restore_interrupt_state( state );
+  return waiter.result;
+}
+
+void sys_event_set( kevent_t *event, uint32_t flags ) {
+  if ( !IS_EVENT( event ) ) {
+    return;
+  }
+
+  int state = save_interrupt_state_and_disable();
+  uint32_t waiters = event->waiters;
+
+  event->flags |= flags;
+  while ( waiters ) {
+    uint32_t i = __builtin_ctz( waiters );
+    event_waiter_t *waiter = sched_wait_record( i );
+    uint32_t matched = event_match( event->flags, waiter->mask, waiter->options );
+
+    waiters &= waiters - 1;
+    if ( matched ) {
+      waiter->result = matched;
+      if ( waiter->options & EVENT_CLEAR ) {
+        event->flags &= ~matched;
+      }
+      sched_wake( &event->waiters, i );
+    }
+  }
+  restore_interrupt_state( state );
+}
+
+void sys_event_clear( kevent_t *event, uint32_t flags ) {
+  if ( !IS_EVENT( event ) ) {
+    return;
+  }
+
+  int state = save_interrupt_state_and_disable();
+
+  event->flags &= ~flags;
+  restore_interrupt_state( state );
+}
+
+kqueue_t *sys_queue_init( uint32_t msg_size, uint32_t capacity ) {
+  if ( queue_count >= MAX_MSG_QUEUES || msg_size == 0 || capacity == 0 ) {
+    return NULL;
+  }
+
+  // Slots stay word aligned for whatever the messages hold.
+  uint32_t slot_size = ( msg_size + 3 ) & ~3U;
+
+  if ( capacity > ( MSG_QUEUE_POOL_SIZE - queue_pool_used ) / slot_size ) {
+    return NULL;
+  }
+
+  kqueue_t *queue = &queues[ queue_count++ ];
+
+  queue->buffer = &queue_pool[ queue_pool_used ];
+  queue_pool_used += slot_size * capacity;
+  queue->msg_size = msg_size;
+  queue->capacity = capacity;
+  queue->head = 0;
+  queue->count = 0;
+  queue->senders = 0;
+  queue->receivers = 0;
+  return queue;
+}
+
+int sys_queue_send( kqueue_t *queue, const void *msg, uint32_t timeout ) {
+  if ( !IS_QUEUE( queue ) ) {
+    return -1;
+  }
+
+  int state = save_interrupt_state_and_disable();
+  int result = 0;
+
+  if ( queue->receivers ) {
+    // The queue is empty, so the message goes straight to the receiver.
+    uint32_t i = __builtin_ctz( queue->receivers );
+
+    k_memcpy( sched_wait_record( i ), msg, queue->msg_size );
+    sched_wake( &queue->receivers, i );
+  } else if ( queue->count < queue->capacity ) {
+    k_memcpy( queue_slot( queue, queue->count ), msg, queue->msg_size );
+    queue->count++;
+  } else {
+    // sys_queue_recv() copies the message in when it makes room.
+    result = sched_sleep( &queue->senders, ( void * )msg, timeout, &state );
+  }
+  restore_interrupt_state( state );
+  return result;
+}
+
+int sys_queue_recv( kqueue_t *queue, void *msg, uint32_t timeout ) {
+  if ( !IS_QUEUE( queue ) ) {
+    return -1;
+  }
+
+  int state = save_interrupt_state_and_disable();
+  int result = 0;
+
+  if ( queue->count ) {
+    k_memcpy( msg, queue_slot( queue, 0 ), queue->msg_size );
+    queue->head = queue->head + 1 < queue->capacity ? queue->head + 1 : 0;
+    queue->count--;
+
+    // Refill the freed slot from the highest priority sender.
+    if ( queue->senders ) {
+      uint32_t i = __builtin_ctz( queue->senders );
+
+      k_memcpy( queue_slot( queue, queue->count ), sched_wait_record( i ), queue->msg_size );
+      queue->count++;
+      sched_wake( &queue->senders, i );
+    }
+  } else {
+    // sys_queue_send() copies the message out to msg.
+    result = sched_sleep( &queue->receivers, msg, timeout, &state );
+  }
+  restore_interrupt_state( state );
+  return result;
+}
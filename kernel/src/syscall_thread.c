@@ -1,23 +1,96 @@
 /** @file   syscall_thread.c
  *
- *  @brief  
+ *  @brief  Rate-monotonic thread scheduler.
  *
- *  @date   
+ *          Thread i runs at static priority i (0 is highest). Each period a
+ *          thread may run for C ticks; once the budget is used, or it calls
+ *          wait_until_next_period(), it waits for its next release. The idle
+ *          thread runs when nothing else is runnable, and main() resumes from
+ *          scheduler_start() once every thread has been killed.
  *
- *  @author 
+ *          Mutexes follow the priority ceiling protocol. A thread that holds
+ *          a mutex runs at the highest ceiling it holds, and may only lock
+ *          when its priority is above the system ceiling, the highest ceiling
+ *          held by any other thread. A mutex with ceiling c can only be locked
+ *          by threads of priority c or lower, so each ceiling level is held by
+ *          at most one thread at a time. That lets the system ceiling live in
+ *          a bitmap of held levels with an owner per level, and makes lock,
+ *          unlock and the blocking check constant time whatever max_mutexes
+ *          is.
+ *
+ *          With SHARED_STACK protection every thread runs its function as a
+ *          run-to-completion job each period, and all jobs share the user and
+ *          kernel stack regions as in the Stack Resource Policy. A job only
+ *          starts once it is above every ceiling held by a ready thread, so it
+ *          never blocks, and jobs can only be preempted by higher priority
+ *          ones. The live jobs therefore nest like interrupt frames: a new job
+ *          is built right below the one it preempts, and a finished job's
+ *          context is simply dropped at the switch. Sleeping is refused and
+ *          budgets are not enforced, since a job suspended mid-stack would be
+ *          overwritten by the jobs below it.
+ *
+ *          Every switch also updates which threads are blocked, for the
+ *          statistics in lock_stats.h. Blocking only starts or ends when the
+ *          ready set or the ceilings change, and each of those pends a switch.
+ *
+ *          Context switches only happen in pendsv_c_handler(), through the
+ *          target interface in context.h.
  */
 
 #include <stdint.h>
+#include <kstring.h>
+#include "arm.h"
+#include "context.h"
+#include "kmalloc.h"
+#include "printk.h"
+#include "syscall.h"
 #include "syscall_thread.h"
 #include "syscall_mutex.h"
+#include "syscall_sync.h"
+#include "syscall_timer.h"
+#include "boot_time.h"
+#include "clock.h"
+#include "dwt.h"
+#include "release_timer.h"
+#include "time_page.h"
+#include "timer.h"
+
+/** @brief      TCB index of the idle thread. */
+#define IDLE_THREAD MAX_THREADS
+/** @brief      TCB index of the main thread. */
+#define MAIN_THREAD ( MAX_THREADS + 1 )
+/** @brief      Number of TCBs. */
+#define NUM_TCBS ( MAX_THREADS + 2 )
+
+/** @brief      Maximum number of mutexes. */
+#define MAX_MUTEXES 32
 
-/** @brief      Initial XPSR value, all 0s except thumb bit. */
-#define XPSR_INIT 0x1000000
+/** @brief      locked_by of a free mutex. */
+#define NO_THREAD NUM_TCBS
 
-/** @brief Interrupt return code to user mode using PSP.*/
-#define LR_RETURN_TO_USER_PSP 0xFFFFFFFD
-/** @brief Interrupt return code to kernel mode using MSP.*/
-#define LR_RETURN_TO_KERNEL_MSP 0xFFFFFFF1
+/** @brief      Size of each of the user and kernel stack regions. */
+#define THREAD_STACK_REGION_SIZE ( 32 * 1024 )
+
+/**
+ * @brief      Kernel stack left below a context before a job is built under it,
+ *             for the PendSV handler that builds it and anything that
+ *             interrupts that handler.
+ *
+ *             The preempted job's context is where _pend_sv_ pushed it, so the
+ *             40 byte switch frame is above the reserve, along with any SVC
+ *             handler PendSV preempted. Below it, pendsv_c_handler() saves
+ *             r4-r11 and lr, about 40 bytes with its locals, and its deepest
+ *             callee, context_init() or a cpu_isr hook, a few words more. Only
+ *             the UART interrupt outranks PendSV, and it adds a 32 byte
+ *             exception frame, or 104 bytes if a FLOAT=hard kernel had used
+ *             the FPU in PendSV, plus 4 for alignment, and uart_irq_handler()
+ *             with cpu_isr_exit() under 32. That is about 230 bytes at worst,
+ *             and test_10_4 nests jobs three deep to exercise it.
+ */
+#define SRP_KSTACK_RESERVE 256
+
+/** @brief      UB bound for more threads than ub_table covers, ln 2. */
+#define UB_LIMIT 0.6931f
 
 /**
  * @brief      Heap high and low pointers.
@@ -44,25 +117,594 @@ float ub_table[] = {
 };
 
 /**
- * @struct user_stack_frame
+ * @enum thread_state
+ *
+ * @brief      Lifecycle of a TCB.
+ */
+typedef enum {
+  THREAD_UNUSED = 0, /**< Slot free */
+  THREAD_RUNNABLE,   /**< Has budget left in its current period */
+  THREAD_WAITING,    /**< Waiting for its next release */
+  THREAD_DONE        /**< Killed */
+} thread_state;
+
+/**
+ * @struct tcb_t
  *
- * @brief  Stack frame upon exception.
+ * @brief      Thread control block.
  */
 typedef struct {
-  uint32_t r0;   /** @brief Register value for r0 */
-  uint32_t r1;   /** @brief Register value for r1 */
-  uint32_t r2;   /** @brief Register value for r2 */
-  uint32_t r3;   /** @brief Register value for r3 */
-  uint32_t r12;  /** @brief Register value for r12 */
-  uint32_t lr;   /** @brief Register value for lr*/
-  uint32_t pc;   /** @brief Register value for pc */
-  uint32_t xPSR; /** @brief Register value for xPSR */
-} interrupt_stack_frame;
+  void *context;         /**< Saved context, see context.h */
+  int svc_status;        /**< SVCALLACT at the time of the switch */
+  thread_state state;    /**< Current state */
+  uint32_t prio;         /**< Static priority, also the TCB index */
+  uint32_t eff_prio;     /**< Effective priority */
+  uint32_t C;            /**< Budget per period, in ticks */
+  uint32_t T;            /**< Period, in ticks */
+  release_node_t release; /**< Next period boundary, see release_now() */
+  uint32_t budget_used;  /**< Ticks run in the current period */
+  uint32_t total_time;   /**< Whole ticks run since creation */
+  uint32_t run_cycles;   /**< Cycles run beyond total_time */
+  uint32_t held_ceilings; /**< Bit c while holding a mutex of ceiling c */
+  uint32_t *futex;       /**< Word it sleeps on in futex_wait(), if any */
+  wait_list_t *wait_list; /**< List it sleeps on in sched_sleep(), if any */
+  void *wait_record;     /**< Record given to sched_sleep() */
+  uint32_t wait_deadline; /**< Tick its sched_sleep() times out at */
+  int wait_timed_out;    /**< Whether the last sched_sleep() timed out */
+  uint32_t block_start;  /**< Cycle count when it last became blocked */
+  int32_t block_mutex;   /**< Mutex at the system ceiling then, or -1 */
+  thread_block_stats_t block_stats; /**< See lock_stats.h */
+  void *fn;              /**< Thread function */
+  void *vargp;           /**< Argument for fn */
+  void *kstack;          /**< Kernel stack allocation */
+  void *ustack;          /**< User stack allocation */
+} tcb_t;
+
+/** @brief      Thread control blocks, indexed by priority. */
+static tcb_t tcbs[ NUM_TCBS ];
+
+/** @brief      TCB index of the running thread. */
+static uint32_t current = MAIN_THREAD;
+
+/** @brief      Shared with user mode at TIME_PAGE_ADDR, see time_page.h. */
+time_page_t time_page __attribute__( ( section( ".time_page" ),
+                                       aligned( 1 << TIME_PAGE_SIZE_LOG2 ) ) );
+
+/** @brief      Bit i is set while thread i is RUNNABLE. */
+static uint32_t ready_mask;
+
+/**
+ * @brief      Bit i is set while thread i waits in mutex_lock() or
+ *             futex_wait(). Both retry, so waking too many is harmless.
+ */
+static uint32_t blocked_mask;
+
+/**
+ * @brief      Bit i is set while thread i sleeps in sched_sleep(), and also in
+ *             timeout_mask if that sleep has a deadline.
+ */
+//@{
+static uint32_t sleep_mask;
+static uint32_t timeout_mask;
+//@}
+
+/** @brief      Mutexes handed out by mutex_init(). */
+//@{
+static kmutex_t mutexes[ MAX_MUTEXES ];
+static uint32_t mutex_count;
+static uint32_t max_mutexes_allowed;
+//@}
+
+/**
+ * @brief      System ceiling: bit c is set while ceiling_holds[ c ] mutexes of
+ *             ceiling c are locked, all by ceiling_owner[ c ].
+ */
+//@{
+static uint32_t ceiling_mask;
+static uint8_t ceiling_holds[ MAX_THREADS ];
+static uint8_t ceiling_owner[ MAX_THREADS ];
+//@}
+
+/** @brief      Mutex last locked at each ceiling level, blamed for blocking. */
+static kmutex_t *ceiling_mutex[ MAX_THREADS ];
+
+/** @brief      Bit i is set while thread i counts as blocked, see lock_stats.h. */
+static uint32_t blocking_mask;
+
+/**
+ * @brief      Release clock units per tick: microseconds when
+ *             scheduler_start() got the release timer going, or 1 when
+ *             releases fall back to the tick count.
+ */
+static uint32_t release_units_per_tick = 1;
+
+/** @brief      Whether releases run off the release timer. */
+static int release_timer_running;
+
+/** @brief      Whether thread_init() got SHARED_STACK. */
+static int shared_stacks;
+
+/** @brief      Bit i is set while thread i has a job on the shared stacks. */
+static uint32_t srp_jobs;
+
+/** @brief      Number of created threads that are not DONE. */
+static uint32_t live_count;
+
+/** @brief      Parameters given to thread_init(). */
+//@{
+static uint32_t max_threads_allowed;
+static uint32_t stack_bytes;
+//@}
+
+/** @brief      Whether the scheduler is running. */
+static int scheduler_running;
+
+/** @brief      Length of a tick in microseconds, set by scheduler_start(). */
+static uint32_t tick_us;
+
+/**
+ * @brief      One bucket of CPU time in DWT cycles, see cpu_stats.h.
+ */
+typedef struct {
+  uint32_t length;                  /**< Cycles it covers */
+  uint32_t isr;                     /**< Cycles in interrupt handlers */
+  uint32_t switches;                /**< Context switches */
+  uint32_t run[ NUM_TCBS ];         /**< Cycles each thread ran */
+  uint16_t switched_in[ NUM_TCBS ]; /**< Times each thread was switched in */
+} cpu_bucket_t;
+
+/**
+ * @brief      CPU accounting. The buckets are a ring, cpu_fill the one filling
+ *             up and the cpu_complete before it complete.
+ */
+//@{
+static cpu_bucket_t cpu_buckets[ CPU_STATS_BUCKETS + 1 ];
+static uint32_t cpu_fill;
+static uint32_t cpu_complete;
+static uint32_t cpu_bucket_start;  /**< Cycle count cpu_fill started at */
+static uint32_t cpu_bucket_cycles; /**< CPU_STATS_BUCKET_US in cycles */
+static uint32_t cpu_cycles_per_us;
+static uint32_t cpu_tick_cycles;   /**< Cycles per tick, for total_time */
+static uint32_t cpu_mark;          /**< Cycle count running was charged up to */
+static uint32_t isr_cycles;        /**< Handler cycles since cpu_mark */
+static uint32_t isr_depth;         /**< Handlers active, nested ones included */
+static uint32_t isr_start;         /**< Cycle count the outermost one began */
+//@}
+
+/** @brief      Allocators for the user and kernel stack regions. */
+//@{
+static kmalloc_t u_stacks;
+static kmalloc_t k_stacks;
+//@}
+
+/** @brief      User-mode stub that kills the calling thread. */
+void thread_kill( void );
+
+/** @brief      User-mode stub that ends a job in SHARED_STACK mode. */
+void wait_until_next_period( void );
+
+/** @brief      User-mode stub for sys_sleep_till_interrupt(). */
+void sleep_till_interrupt( void );
+
+/**
+ * @brief      Kernel idle function, used when thread_init() gets no idle_fn.
+ *             Sleeping through the kernel lets it skip the ticks nothing
+ *             happens on.
+ */
+static void default_idle( void ) {
+  while ( 1 ) {
+    sleep_till_interrupt();
+  }
+}
 
+/**
+ * @brief      Rounds up to the next power of two.
+ */
+static uint32_t round_up_pow2( uint32_t x ) {
+  uint32_t result = 1;
 
-void *pendsv_c_handler(void *context_ptr){
-  (void) context_ptr;
-  return NULL;
+  while ( result < x ) {
+    result <<= 1;
+  }
+  return result;
+}
+
+/**
+ * @brief      Marks a thread runnable or not.
+ */
+static void set_ready( uint32_t index, int ready ) {
+  if ( index >= MAX_THREADS ) {
+    return;
+  }
+  if ( ready ) {
+    ready_mask |= 1U << index;
+  } else {
+    ready_mask &= ~( 1U << index );
+  }
+}
+
+/**
+ * @brief      Picks the thread to run next. A mutex holder runs at its highest
+ *             ceiling and wins ties with the thread of that priority. Only
+ *             levels above the best ready thread are looked at, and the first
+ *             one whose owner is ready wins, normally at once.
+ */
+static uint32_t pick_next( void ) {
+  uint32_t first = ready_mask ? __builtin_ctz( ready_mask ) : MAX_THREADS;
+  uint32_t levels = first < MAX_THREADS ? ceiling_mask & ( ( 2U << first ) - 1 )
+                                        : ceiling_mask;
+
+  while ( levels ) {
+    uint32_t owner = ceiling_owner[ __builtin_ctz( levels ) ];
+
+    if ( owner < MAX_THREADS && ( ready_mask & ( 1U << owner ) ) ) {
+      return owner;
+    }
+    levels &= levels - 1;
+  }
+
+  if ( first < MAX_THREADS ) {
+    return first;
+  }
+  return live_count ? IDLE_THREAD : MAIN_THREAD;
+}
+
+/**
+ * @brief      Recomputes a thread's effective priority from the ceilings it
+ *             holds.
+ */
+static void update_eff_prio( uint32_t index ) {
+  tcb_t *tcb = &tcbs[ index ];
+  uint32_t eff_prio = tcb->prio;
+
+  if ( tcb->held_ceilings && ( uint32_t )__builtin_ctz( tcb->held_ceilings ) < eff_prio ) {
+    eff_prio = __builtin_ctz( tcb->held_ceilings );
+  }
+  tcb->eff_prio = eff_prio;
+  if ( index == current ) {
+    time_page.priority = eff_prio;
+    time_page.ceilings = ceiling_mask & ~tcb->held_ceilings;
+  }
+}
+
+/**
+ * @brief      Gives up one lock on mutex, which index holds. Threads blocked in
+ *             mutex_lock() retry once a ceiling level is freed. Call with
+ *             interrupts disabled.
+ */
+static void mutex_release( kmutex_t *mutex, uint32_t index ) {
+  uint32_t ceil = mutex->prio_ceil;
+  uint32_t held = dwt_get_cycles() - mutex->hold_start;
+
+  mutex->stats.total_hold += held;
+  if ( held > mutex->stats.max_hold ) {
+    mutex->stats.max_hold = held;
+  }
+  mutex->locked_by = NO_THREAD;
+  if ( --ceiling_holds[ ceil ] == 0 ) {
+    ceiling_mask &= ~( 1U << ceil );
+    tcbs[ index ].held_ceilings &= ~( 1U << ceil );
+    update_eff_prio( index );
+
+    ready_mask |= blocked_mask;
+    blocked_mask = 0;
+  }
+}
+
+/**
+ * @brief      Starts and ends blocking intervals for the switch to running:
+ *             threads waiting on a lock, and ready threads above running's
+ *             static priority, which only lose to it through a ceiling.
+ */
+static void update_blocking( uint32_t running ) {
+  uint32_t blocking = blocked_mask;
+  uint32_t now = dwt_get_cycles();
+
+  if ( running < MAX_THREADS ) {
+    blocking |= ready_mask & ( ( 1U << running ) - 1 );
+  }
+  if ( blocking == blocking_mask ) {
+    return;
+  }
+
+  uint32_t started = blocking & ~blocking_mask;
+  uint32_t ended = blocking_mask & ~blocking;
+
+  while ( started ) {
+    tcb_t *tcb = &tcbs[ __builtin_ctz( started ) ];
+
+    started &= started - 1;
+    tcb->block_start = now;
+    tcb->block_mutex = ceiling_mask ? ceiling_mutex[ __builtin_ctz( ceiling_mask ) ] - mutexes : -1;
+  }
+  while ( ended ) {
+    tcb_t *tcb = &tcbs[ __builtin_ctz( ended ) ];
+    uint32_t blocked = now - tcb->block_start;
+
+    ended &= ended - 1;
+    tcb->block_stats.blocked_count++;
+    tcb->block_stats.total_blocked += blocked;
+    if ( blocked > tcb->block_stats.max_blocked ) {
+      tcb->block_stats.max_blocked = blocked;
+      tcb->block_stats.max_mutex = tcb->block_mutex;
+    }
+  }
+  blocking_mask = blocking;
+}
+
+// The UART interrupt preempts the others, so both run with it masked.
+void cpu_isr_enter( void ) {
+  int state = save_interrupt_state_and_disable();
+
+  if ( isr_depth++ == 0 ) {
+    isr_start = dwt_get_cycles();
+  }
+  restore_interrupt_state( state );
+}
+
+void cpu_isr_exit( void ) {
+  int state = save_interrupt_state_and_disable();
+
+  if ( --isr_depth == 0 ) {
+    uint32_t spent = dwt_get_cycles() - isr_start;
+
+    isr_cycles += spent;
+    cpu_buckets[ cpu_fill ].isr += spent;
+  }
+  restore_interrupt_state( state );
+}
+
+/**
+ * @brief      Charges the running thread for the cycles since cpu_mark, less
+ *             the handlers that ran meanwhile. Called from a handler, whose
+ *             own time cpu_isr_exit() counts. This is the only charge: the
+ *             same cycles go to the CPU bucket and to total_time, so a thread
+ *             that runs part of a tick is charged that part, and thread_time()
+ *             always agrees with cpu_stats().
+ */
+static void cpu_charge( void ) {
+  tcb_t *tcb = &tcbs[ current ];
+  uint32_t ran = isr_start - cpu_mark - isr_cycles;
+
+  cpu_buckets[ cpu_fill ].run[ current ] += ran;
+  cpu_mark = isr_start;
+  isr_cycles = 0;
+
+  tcb->run_cycles += ran;
+  while ( tcb->run_cycles >= cpu_tick_cycles ) {
+    tcb->run_cycles -= cpu_tick_cycles;
+    tcb->total_time++;
+  }
+}
+
+/**
+ * @brief      Completes the filling bucket once it is CPU_STATS_BUCKET_US
+ *             long, dropping the oldest complete one. Called right after
+ *             cpu_charge().
+ */
+static void cpu_rotate( void ) {
+  if ( isr_start - cpu_bucket_start < cpu_bucket_cycles ) {
+    return;
+  }
+
+  cpu_buckets[ cpu_fill ].length = isr_start - cpu_bucket_start;
+  cpu_bucket_start = isr_start;
+  cpu_fill = cpu_fill == CPU_STATS_BUCKETS ? 0 : cpu_fill + 1;
+  if ( cpu_complete < CPU_STATS_BUCKETS ) {
+    cpu_complete++;
+  }
+  k_memset( &cpu_buckets[ cpu_fill ], 0, sizeof( cpu_buckets[ cpu_fill ] ) );
+}
+
+/**
+ * @brief      Restarts CPU accounting, with the scheduler.
+ *
+ * @param[in]  frequency  Ticks per second.
+ */
+static void cpu_reset( uint32_t frequency ) {
+  cpu_tick_cycles = clock_get_hclk_hz() / frequency;
+  cpu_cycles_per_us = clock_get_hclk_hz() / 1000000;
+  cpu_bucket_cycles = CPU_STATS_BUCKET_US * cpu_cycles_per_us;
+  k_memset( cpu_buckets, 0, sizeof( cpu_buckets ) );
+  cpu_fill = 0;
+  cpu_complete = 0;
+  cpu_bucket_start = dwt_get_cycles();
+  cpu_mark = cpu_bucket_start;
+  isr_cycles = 0;
+}
+
+/**
+ * @brief      Reads the clock thread releases are kept in.
+ */
+static uint32_t release_now( void ) {
+  return release_timer_running ? release_timer_now() : systick_get_millis();
+}
+
+/**
+ * @brief      Starts every period and expires every software timer that is due
+ *             at now, then arms the release timer for the earliest of either
+ *             still ahead. Both share the heap in syscall_timer.c.
+ */
+static void release_due( uint32_t now ) {
+  uint32_t earliest;
+
+  release_expire( now );
+
+  if ( !release_timer_running ) {
+    return;
+  }
+  if ( release_next( &earliest ) ) {
+    release_timer_arm( earliest );
+  } else {
+    release_timer_cancel();
+  }
+}
+
+void sched_release( uint32_t index ) {
+  tcb_t *tcb = &tcbs[ index ];
+
+  tcb->release.at += tcb->T * release_units_per_tick;
+  tcb->budget_used = 0;
+  tcb->state = THREAD_RUNNABLE;
+  // A blocked or sleeping thread stays that way.
+  set_ready( index, !( ( blocked_mask | sleep_mask ) & ( 1U << index ) ) );
+}
+
+/**
+ * @brief      Allocates both stacks of a TCB and builds its first context.
+ */
+static int tcb_setup( tcb_t *tcb, void *fn, void *vargp ) {
+  tcb->kstack = k_malloc_aligned( &k_stacks );
+  tcb->ustack = k_malloc_aligned( &u_stacks );
+  if ( !tcb->kstack || !tcb->ustack ) {
+    if ( tcb->kstack ) k_free( &k_stacks, tcb->kstack );
+    if ( tcb->ustack ) k_free( &u_stacks, tcb->ustack );
+    return -1;
+  }
+
+  tcb->context = context_init( ( char * )tcb->kstack + stack_bytes,
+                               ( char * )tcb->ustack + stack_bytes,
+                               fn, vargp, ( void * )&thread_kill );
+  tcb->svc_status = 0;
+  return 0;
+}
+
+/**
+ * @brief      Builds a fresh job for thread index on the shared stacks, right
+ *             below the newest live job.
+ *
+ *             If the newest live job is the one being switched out, this
+ *             handler runs just below it and the new job goes below
+ *             SRP_KSTACK_RESERVE. If a job finished, its SVC and PendSV frames
+ *             are dead and the new job is built over them, which is safe only
+ *             while the handler's live frames, all below the finished job's
+ *             context, stay clear of the new one. Otherwise the handler runs
+ *             on the idle or main thread's stack.
+ *
+ * @param[in]  index  The thread.
+ * @param[in]  prev   The thread being switched out.
+ */
+static void srp_start_job( uint32_t index, uint32_t prev ) {
+  tcb_t *tcb = &tcbs[ index ];
+  void *ktop = &__thread_k_stacks_top;
+  void *utop = &__thread_u_stacks_top;
+  int reserve = prev < MAX_THREADS && ( srp_jobs & ( 1U << prev ) );
+
+  if ( srp_jobs ) {
+    context_stack_limits( tcbs[ __builtin_ctz( srp_jobs ) ].context, &ktop, &utop );
+  }
+#ifndef HOST_SIM
+  // Host contexts have their own stacks, so there is nothing to overwrite.
+  if ( !reserve && prev < MAX_THREADS ) {
+    void *live, *unused;
+
+    context_stack_limits( tcbs[ prev ].context, &live, &unused );
+    reserve = ( char * )( ( uintptr_t )ktop & ~7U ) - CONTEXT_KSTACK_BYTES <
+              ( char * )live;
+  }
+#endif
+  if ( reserve ) {
+    ktop = ( char * )ktop - SRP_KSTACK_RESERVE;
+  }
+
+  tcb->context = context_init( ( void * )( ( uintptr_t )ktop & ~7U ),
+                               ( void * )( ( uintptr_t )utop & ~7U ),
+                               tcb->fn, tcb->vargp,
+                               ( void * )&wait_until_next_period );
+  tcb->svc_status = 0;
+  srp_jobs |= 1U << index;
+}
+
+void sched_tick( uint32_t now ) {
+  time_page.ticks = now;
+
+  if ( !scheduler_running ) {
+    return;
+  }
+
+  cpu_charge();
+  time_page.thread_time = tcbs[ current ].total_time;
+  cpu_rotate();
+
+  if ( current < MAX_THREADS ) {
+    tcb_t *tcb = &tcbs[ current ];
+
+    if ( ++tcb->budget_used >= tcb->C && tcb->state == THREAD_RUNNABLE &&
+         !shared_stacks ) {
+      tcb->state = THREAD_WAITING;
+      set_ready( current, 0 );
+    }
+  }
+
+  uint32_t expiring = timeout_mask;
+
+  while ( expiring ) {
+    uint32_t i = __builtin_ctz( expiring );
+
+    expiring &= expiring - 1;
+    if ( ( int32_t )( now - tcbs[ i ].wait_deadline ) >= 0 ) {
+      tcbs[ i ].wait_timed_out = 1;
+      sched_wake( tcbs[ i ].wait_list, i );
+    }
+  }
+
+  // The release timer interrupts for releases between ticks, but one that
+  // falls on this tick is taken here so the switch below sees it.
+  release_due( release_now() );
+
+  pend_pendsv();
+}
+
+uint32_t sched_release_now( void ) {
+  return release_now();
+}
+
+uint32_t sched_release_units( void ) {
+  return release_units_per_tick;
+}
+
+void sched_release_update( void ) {
+  if ( scheduler_running ) {
+    release_due( release_now() );
+  }
+}
+
+void sched_release_timer( void ) {
+  if ( !scheduler_running ) {
+    return;
+  }
+  release_due( release_now() );
+  pend_pendsv();
+}
+
+RAMFUNC void *pendsv_c_handler( void *context_ptr ){
+  uint32_t prev = current;
+  tcb_t *tcb = &tcbs[ current ];
+
+  cpu_isr_enter();
+  tcb->context = context_ptr;
+  tcb->svc_status = get_svc_status();
+  if ( scheduler_running ) {
+    cpu_charge();
+  }
+
+  current = pick_next();
+  update_blocking( current );
+  if ( shared_stacks && current < MAX_THREADS && !( srp_jobs & ( 1U << current ) ) ) {
+    srp_start_job( current, prev );
+  }
+  tcb = &tcbs[ current ];
+  time_page.priority = tcb->eff_prio;
+  time_page.ceilings = ceiling_mask & ~tcb->held_ceilings;
+  time_page.thread_time = tcb->total_time;
+  if ( current != prev ) {
+    cpu_buckets[ cpu_fill ].switches++;
+    cpu_buckets[ cpu_fill ].switched_in[ current ]++;
+  }
+
+  set_svc_status( tcb->svc_status );
+  cpu_isr_exit();
+  return tcb->context;
 }
 
 int sys_thread_init(
@@ -72,9 +714,75 @@ int sys_thread_init(
   protection_mode memory_protection,
   uint32_t max_mutexes
 ){
-  (void) max_threads; (void) stack_size; (void) idle_fn;
-  (void) memory_protection; (void) max_mutexes;
-  return -1;
+  if ( scheduler_running || max_threads == 0 || max_threads > MAX_THREADS ||
+       max_mutexes > MAX_MUTEXES || memory_protection > SHARED_STACK ) {
+    return -1;
+  }
+
+  // Stacks are power-of-two sized and aligned so they can back MPU regions.
+  stack_bytes = round_up_pow2( stack_size * sizeof( uint32_t ) );
+  if ( stack_bytes < 256 ) {
+    stack_bytes = 256;
+  }
+  shared_stacks = memory_protection == SHARED_STACK;
+  if ( shared_stacks ) {
+    // The idle thread's stacks at the bottom, the shared ones above them.
+    if ( 2 * stack_bytes > THREAD_STACK_REGION_SIZE ) {
+      return -1;
+    }
+    k_malloc_init( &u_stacks, &__thread_u_stacks_low, &__thread_u_stacks_low + stack_bytes, stack_bytes, 0 );
+    k_malloc_init( &k_stacks, &__thread_k_stacks_low, &__thread_k_stacks_low + stack_bytes, stack_bytes, 0 );
+  } else {
+    // One stack per thread plus the idle thread's.
+    if ( ( max_threads + 1 ) * stack_bytes > THREAD_STACK_REGION_SIZE ) {
+      return -1;
+    }
+    k_malloc_init( &u_stacks, &__thread_u_stacks_low, &__thread_u_stacks_top, stack_bytes, 0 );
+    k_malloc_init( &k_stacks, &__thread_k_stacks_low, &__thread_k_stacks_top, stack_bytes, 0 );
+  }
+  srp_jobs = 0;
+
+  for ( uint32_t i = 0; i < NUM_TCBS; i++ ) {
+    tcbs[ i ].state = THREAD_UNUSED;
+    tcbs[ i ].prio = i;
+    tcbs[ i ].eff_prio = i;
+    tcbs[ i ].held_ceilings = 0;
+    tcbs[ i ].release.id = i;
+    tcbs[ i ].release.heap_pos = -1;
+    k_memset( &tcbs[ i ].block_stats, 0, sizeof( tcbs[ i ].block_stats ) );
+    tcbs[ i ].block_stats.max_mutex = -1;
+  }
+  max_threads_allowed = max_threads;
+  max_mutexes_allowed = max_mutexes;
+  mutex_count = 0;
+  ceiling_mask = 0;
+  blocked_mask = 0;
+  blocking_mask = 0;
+  sleep_mask = 0;
+  timeout_mask = 0;
+  sync_reset();
+  timer_reset();
+  ready_mask = 0;
+  live_count = 0;
+  current = MAIN_THREAD;
+  time_page.priority = MAIN_THREAD;
+  time_page.ceilings = 0;
+  time_page.thread_time = 0;
+
+  if ( !idle_fn ) {
+    idle_fn = ( void * )&default_idle;
+  }
+  if ( tcb_setup( &tcbs[ IDLE_THREAD ], idle_fn, NULL ) ) {
+    return -1;
+  }
+  tcbs[ IDLE_THREAD ].state = THREAD_RUNNABLE;
+  tcbs[ MAIN_THREAD ].state = THREAD_RUNNABLE;
+  for ( uint32_t i = IDLE_THREAD; i <= MAIN_THREAD; i++ ) {
+    tcbs[ i ].total_time = 0;
+    tcbs[ i ].run_cycles = 0;
+  }
+
+  return 0;
 }
 
 int sys_thread_create(
@@ -84,42 +792,492 @@ int sys_thread_create(
   uint32_t T,
   void *vargp
 ){
-  (void) fn; (void) prio; (void) C; (void) T; (void) vargp;
-  return -1;
+  // A killed thread's slot can be reused.
+  if ( prio >= max_threads_allowed ||
+       ( tcbs[ prio ].state != THREAD_UNUSED && tcbs[ prio ].state != THREAD_DONE ) ) {
+    return -1;
+  }
+  if ( C == 0 || C > T ) {
+    return -1;
+  }
+
+  // Liu and Layland utilization bound over the new set.
+  uint32_t n = 1;
+  float utilization = ( float )C / T;
+  for ( uint32_t i = 0; i < max_threads_allowed; i++ ) {
+    if ( tcbs[ i ].state == THREAD_RUNNABLE || tcbs[ i ].state == THREAD_WAITING ) {
+      utilization += ( float )tcbs[ i ].C / tcbs[ i ].T;
+      n++;
+    }
+  }
+  if ( utilization > ( n < sizeof( ub_table ) / sizeof( ub_table[ 0 ] ) ? ub_table[ n ] : UB_LIMIT ) ) {
+    return -1;
+  }
+
+  int state = save_interrupt_state_and_disable();
+  tcb_t *tcb = &tcbs[ prio ];
+
+  // Jobs on the shared stacks are built when they first run.
+  if ( !shared_stacks && tcb_setup( tcb, fn, vargp ) ) {
+    restore_interrupt_state( state );
+    return -1;
+  }
+  tcb->fn = fn;
+  tcb->vargp = vargp;
+  tcb->C = C;
+  tcb->T = T;
+  tcb->eff_prio = prio;
+  tcb->held_ceilings = 0;
+  k_memset( &tcb->block_stats, 0, sizeof( tcb->block_stats ) );
+  tcb->block_stats.max_mutex = -1;
+  tcb->budget_used = 0;
+  tcb->total_time = 0;
+  tcb->run_cycles = 0;
+  // Periods start at the exact instant of creation, not the tick before it.
+  tcb->release.at = release_now() + T * release_units_per_tick;
+  release_schedule( &tcb->release );
+  tcb->state = THREAD_RUNNABLE;
+  set_ready( prio, 1 );
+  live_count++;
+  // The new release may come before the one the timer is armed for.
+  sched_release_update();
+  restore_interrupt_state( state );
+
+  return 0;
 }
 
 int sys_scheduler_start( uint32_t frequency ){
-  (void) frequency;
-  return -1;
+#ifdef BOOT_TIME
+  static int boot_reported = 0;
+
+  if ( !boot_reported ) {
+    boot_reported = 1;
+    boot_time_report();
+  }
+#endif
+
+  if ( scheduler_running || frequency == 0 ) {
+    return -1;
+  }
+
+  int state = save_interrupt_state_and_disable();
+
+  // Releases go on the release timer when a tick is a whole number of
+  // microseconds. It starts first so that it never reads behind SysTick.
+  release_timer_running = RELEASE_TIMER_HZ % frequency == 0 &&
+                          release_timer_start() == 0;
+  release_units_per_tick = release_timer_running ? RELEASE_TIMER_HZ / frequency : 1;
+
+  // The tick count restarts at 0, so releases are rebased onto it.
+  if ( timer_start( frequency ) ) {
+    if ( release_timer_running ) {
+      release_timer_stop();
+      release_timer_running = 0;
+    }
+    restore_interrupt_state( state );
+    return -1;
+  }
+  for ( uint32_t i = 0; i < max_threads_allowed; i++ ) {
+    tcbs[ i ].release.at = tcbs[ i ].T * release_units_per_tick;
+  }
+  timer_rebase();
+  tick_us = 1000000 / frequency;
+  cpu_reset( frequency );
+  time_page.ticks = 0;
+  scheduler_running = 1;
+  // Software timers may be due before the first tick.
+  release_due( release_now() );
+  pend_pendsv();
+  restore_interrupt_state( state );
+
+  // Main only runs again once every thread has been killed.
+  scheduler_running = 0;
+  if ( release_timer_running ) {
+    release_timer_stop();
+    release_timer_running = 0;
+  }
+  return 0;
+}
+
+/**
+ * @brief      Cycles to microseconds.
+ */
+static uint32_t cpu_us( uint64_t cycles ) {
+  return ( uint32_t )( cycles / cpu_cycles_per_us );
+}
+
+int sys_cpu_stats( cpu_stats_t *stats ) {
+  uint64_t window = 0, isr = 0, idle = 0, main = 0;
+  int state = save_interrupt_state_and_disable();
+
+  if ( cpu_complete == 0 ) {
+    restore_interrupt_state( state );
+    return -1;
+  }
+
+  // Thread times are summed in cycles in place, a window's worth fits 32 bits.
+  k_memset( stats, 0, sizeof( *stats ) );
+  for ( uint32_t n = 0, b = cpu_fill; n < cpu_complete; n++ ) {
+    cpu_bucket_t *bucket;
+
+    b = b == 0 ? CPU_STATS_BUCKETS : b - 1;
+    bucket = &cpu_buckets[ b ];
+    window += bucket->length;
+    isr += bucket->isr;
+    idle += bucket->run[ IDLE_THREAD ];
+    main += bucket->run[ MAIN_THREAD ];
+    stats->switches += bucket->switches;
+    for ( uint32_t i = 0; i < CPU_STATS_THREADS; i++ ) {
+      stats->threads[ i ].run_us += bucket->run[ i ];
+      stats->threads[ i ].switches += bucket->switched_in[ i ];
+    }
+  }
+
+  stats->window_us = cpu_us( window );
+  stats->tick_us = tick_us;
+  stats->idle_us = cpu_us( idle );
+  stats->main_us = cpu_us( main );
+  stats->isr_us = cpu_us( isr );
+  for ( uint32_t i = 0; i < CPU_STATS_THREADS; i++ ) {
+    cpu_thread_stats_t *t = &stats->threads[ i ];
+
+    t->run_us = cpu_us( t->run_us );
+    if ( i < max_threads_allowed &&
+         tcbs[ i ].state != THREAD_UNUSED && tcbs[ i ].state != THREAD_DONE ) {
+      t->C = tcbs[ i ].C;
+      t->T = tcbs[ i ].T;
+    }
+  }
+  restore_interrupt_state( state );
+  return 0;
 }
 
 uint32_t sys_get_priority(){
-  return 0U;
+  return tcbs[ current ].eff_prio;
 }
 
 uint32_t sys_get_time(){
-  return 0U;
+  return systick_get_millis();
 }
 
 uint32_t sys_thread_time(){
-  return 0U;
+  return tcbs[ current ].total_time;
+}
+
+/**
+ * @brief      Tick boundaries from now to the first one that has work for
+ *             sched_tick(): a sleep timeout, or with releases on ticks a
+ *             release or a software timer. UINT32_MAX if there is none.
+ */
+static uint32_t idle_ticks( void ) {
+  uint32_t now = systick_get_millis();
+  uint32_t limit = UINT32_MAX;
+  uint32_t pending = timeout_mask;
+  uint32_t at;
+
+  while ( pending ) {
+    uint32_t i = __builtin_ctz( pending );
+    int32_t left = ( int32_t )( tcbs[ i ].wait_deadline - now );
+
+    pending &= pending - 1;
+    if ( left <= 0 ) {
+      return 0;
+    }
+    if ( ( uint32_t )left < limit ) {
+      limit = left;
+    }
+  }
+
+  // The release timer wakes the core for these itself.
+  if ( release_timer_running ) {
+    return limit;
+  }
+  if ( release_next( &at ) ) {
+    int32_t left = ( int32_t )( at - now );
+
+    if ( left <= 0 ) {
+      return 0;
+    }
+    if ( ( uint32_t )left < limit ) {
+      limit = left;
+    }
+  }
+  return limit;
+}
+
+void sys_sleep_till_interrupt( void ) {
+  int state = save_interrupt_state_and_disable();
+
+  // Ticks charge budgets and time to the running thread, so only idle can
+  // skip them.
+  timer_sleep( scheduler_running && current == IDLE_THREAD ? idle_ticks() : 0 );
+  time_page.ticks = systick_get_millis();
+  restore_interrupt_state( state );
+}
+
+uint32_t sys_get_pid(){
+  return tcbs[ current ].prio;
+}
+
+/**
+ * @brief      Retires the running thread and pends the switch away from it,
+ *             unlocking its mutexes as sys_thread_kill() documents. Its stacks
+ *             go back to the pools, the switch is the last use.
+ */
+static void kill_current( void ) {
+  int state = save_interrupt_state_and_disable();
+  tcb_t *tcb = &tcbs[ current ];
+
+  for ( uint32_t i = 0; tcb->held_ceilings && i < mutex_count; i++ ) {
+    if ( mutexes[ i ].locked_by == current ) {
+      mutex_release( &mutexes[ i ], current );
+    }
+  }
+  tcb->state = THREAD_DONE;
+  set_ready( current, 0 );
+  release_cancel( &tcb->release );
+  if ( shared_stacks ) {
+    srp_jobs &= ~( 1U << current );
+  } else {
+    k_free( &k_stacks, tcb->kstack );
+    k_free( &u_stacks, tcb->ustack );
+  }
+  live_count--;
+  pend_pendsv();
+  restore_interrupt_state( state );
 }
 
 void sys_thread_kill(){
+  if ( current >= MAX_THREADS ) {
+    printk( "%s thread killed, aborting\n", current == IDLE_THREAD ? "Idle" : "Main" );
+    sys_exit( -1 );
+    breakpoint();
+    return;
+  }
+
+  kill_current();
+}
+
+uint32_t sched_current( void ) {
+  return current;
+}
+
+int sched_fault_kill( uint32_t *thread ) {
+  *thread = current;
+  if ( current >= MAX_THREADS ) {
+    return -1;
+  }
+  kill_current();
+  return 0;
+}
+
+int sys_thread_block_stats( uint32_t prio, thread_block_stats_t *stats, int reset ) {
+  if ( prio >= max_threads_allowed ) {
+    return -1;
+  }
+
+  int state = save_interrupt_state_and_disable();
+  thread_block_stats_t *block_stats = &tcbs[ prio ].block_stats;
+
+  *stats = *block_stats;
+  if ( reset ) {
+    k_memset( block_stats, 0, sizeof( *block_stats ) );
+    block_stats->max_mutex = -1;
+  }
+  restore_interrupt_state( state );
+  return 0;
 }
 
 void sys_wait_until_next_period(){
+  if ( current >= MAX_THREADS ) {
+    return;
+  }
+
+  int state = save_interrupt_state_and_disable();
+  tcb_t *tcb = &tcbs[ current ];
+
+  // The job is over, its frames are dropped at the switch.
+  if ( shared_stacks ) {
+    srp_jobs &= ~( 1U << current );
+  }
+  if ( ( int32_t )( release_now() - tcb->release.at ) >= 0 ) {
+    // Already past the boundary, start the next period right away.
+    tcb->release.at += tcb->T * release_units_per_tick;
+    release_schedule( &tcb->release );
+    tcb->budget_used = 0;
+  } else {
+    tcb->state = THREAD_WAITING;
+    set_ready( current, 0 );
+  }
+  pend_pendsv();
+  restore_interrupt_state( state );
+}
+
+int sys_futex_wait( uint32_t *addr, uint32_t expected ) {
+  if ( current >= MAX_THREADS || shared_stacks ) {
+    return -1;
+  }
+
+  int state = save_interrupt_state_and_disable();
+
+  // Checked with interrupts off, so a wake cannot slip in before the sleep.
+  if ( *( volatile uint32_t * )addr != expected ) {
+    restore_interrupt_state( state );
+    return -1;
+  }
+  tcbs[ current ].futex = addr;
+  blocked_mask |= 1U << current;
+  set_ready( current, 0 );
+  pend_pendsv();
+  restore_interrupt_state( state );
+  return 0;
+}
+
+void sys_futex_wake( uint32_t *addr ) {
+  int state = save_interrupt_state_and_disable();
+  uint32_t waiters = blocked_mask;
+
+  while ( waiters ) {
+    uint32_t i = __builtin_ctz( waiters );
+
+    waiters &= waiters - 1;
+    if ( tcbs[ i ].futex == addr ) {
+      tcbs[ i ].futex = NULL;
+      blocked_mask &= ~( 1U << i );
+      set_ready( i, 1 );
+    }
+  }
+  pend_pendsv();
+  restore_interrupt_state( state );
+}
+
+int sched_sleep( wait_list_t *list, void *record, uint32_t timeout, int *state ) {
+  if ( current >= MAX_THREADS || timeout == 0 || shared_stacks ) {
+    return -1;
+  }
+
+  tcb_t *tcb = &tcbs[ current ];
+  uint32_t bit = 1U << current;
+
+  tcb->wait_list = list;
+  tcb->wait_record = record;
+  tcb->wait_timed_out = 0;
+  *list |= bit;
+  sleep_mask |= bit;
+  if ( timeout != WAIT_FOREVER ) {
+    tcb->wait_deadline = systick_get_millis() + timeout;
+    timeout_mask |= bit;
+  }
+  set_ready( current, 0 );
+  pend_pendsv();
+  // The switch happens here, and sched_wake() makes this thread ready.
+  restore_interrupt_state( *state );
+  *state = save_interrupt_state_and_disable();
+
+  return tcb->wait_timed_out ? -1 : 0;
+}
+
+void *sched_wait_record( uint32_t index ) {
+  return tcbs[ index ].wait_record;
+}
+
+void sched_wake( wait_list_t *list, uint32_t index ) {
+  uint32_t bit = 1U << index;
+
+  *list &= ~bit;
+  sleep_mask &= ~bit;
+  timeout_mask &= ~bit;
+  tcbs[ index ].wait_list = NULL;
+  set_ready( index, 1 );
+  pend_pendsv();
 }
 
 kmutex_t *sys_mutex_init( uint32_t max_prio ) {
-  (void) max_prio;
-  return NULL;
+  if ( mutex_count >= max_mutexes_allowed || max_prio >= MAX_THREADS ) {
+    return NULL;
+  }
+
+  kmutex_t *mutex = &mutexes[ mutex_count++ ];
+
+  mutex->locked_by = NO_THREAD;
+  mutex->prio_ceil = max_prio;
+  k_memset( &mutex->stats, 0, sizeof( mutex->stats ) );
+  return mutex;
 }
 
 void sys_mutex_lock( kmutex_t *mutex ) {
-  (void) mutex;
+  tcb_t *tcb = &tcbs[ current ];
+  uint32_t ceil = mutex->prio_ceil;
+
+  if ( tcb->prio < ceil ) {
+    printk( "Thread %u locked a mutex with ceiling %u, killing it\n",
+            ( unsigned int )current, ( unsigned int )ceil );
+    sys_thread_kill();
+    return;
+  }
+  if ( mutex->locked_by == current ) {
+    printk( "Thread %u already holds this mutex\n", ( unsigned int )current );
+    return;
+  }
+
+  int state = save_interrupt_state_and_disable();
+  int contended = 0;
+
+  // Blocked unless above the system ceiling or its owner. This also covers
+  // the mutex itself being locked, its ceiling is part of the system ceiling.
+  while ( ceiling_mask ) {
+    uint32_t system_ceil = __builtin_ctz( ceiling_mask );
+
+    if ( tcb->eff_prio < system_ceil || ceiling_owner[ system_ceil ] == current ) {
+      break;
+    }
+    contended = 1;
+    blocked_mask |= 1U << current;
+    set_ready( current, 0 );
+    pend_pendsv();
+    // The switch happens here, and mutex_release() makes this thread ready.
+    restore_interrupt_state( state );
+    state = save_interrupt_state_and_disable();
+  }
+
+  mutex->locked_by = current;
+  mutex->hold_start = dwt_get_cycles();
+  mutex->stats.acquisitions++;
+  mutex->stats.contentions += contended;
+  ceiling_holds[ ceil ]++;
+  ceiling_owner[ ceil ] = current;
+  ceiling_mutex[ ceil ] = mutex;
+  ceiling_mask |= 1U << ceil;
+  tcb->held_ceilings |= 1U << ceil;
+  update_eff_prio( current );
+  restore_interrupt_state( state );
 }
 
 void sys_mutex_unlock( kmutex_t *mutex ) {
-  (void) mutex;
+  if ( mutex->locked_by != current ) {
+    printk( "Thread %u unlocked a mutex it does not hold\n", ( unsigned int )current );
+    return;
+  }
+
+  int state = save_interrupt_state_and_disable();
+
+  mutex_release( mutex, current );
+  // Whoever was held off by the ceiling may preempt now.
+  pend_pendsv();
+  restore_interrupt_state( state );
+}
+
+int sys_mutex_stats( kmutex_t *mutex, mutex_stats_t *stats, int reset ) {
+  if ( mutex < mutexes || mutex >= mutexes + mutex_count ) {
+    return -1;
+  }
+
+  int state = save_interrupt_state_and_disable();
+
+  *stats = mutex->stats;
+  if ( reset ) {
+    k_memset( &mutex->stats, 0, sizeof( mutex->stats ) );
+  }
+  restore_interrupt_state( state );
+  return 0;
 }
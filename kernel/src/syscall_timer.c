@@ -0,0 +1,306 @@
+/** @file   syscall_timer.c
+ *
+ *  @brief  Software timers, see syscall_timer.h.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "arm.h"
+#include "syscall_thread.h"
+#include "syscall_timer.h"
+
+/**
+ * @brief      What a thread sleeping in sys_timer_wait() is handed.
+ */
+typedef struct {
+  void *callback;
+  void *arg;
+} timer_fire_t;
+
+/** @brief      Timers handed out by sys_timer_create(). */
+//@{
+static ktimer_t timers[ MAX_SW_TIMERS ];
+static uint32_t timer_count;
+//@}
+
+/** @brief      Thread releases and running timers, a binary min-heap by time. */
+//@{
+static release_node_t *heap[ MAX_THREADS + MAX_SW_TIMERS ];
+static uint32_t heap_len;
+//@}
+
+/** @brief      Expired timers no daemon has taken, oldest first, -1 if none. */
+//@{
+static int32_t expired_head;
+static int32_t expired_tail;
+//@}
+
+/** @brief      Threads sleeping in sys_timer_wait(). */
+static wait_list_t daemons;
+
+/**
+ * @brief      Whether a handle from user mode is a timer sys_timer_create()
+ *             handed out, rather than a pointer anywhere in the kernel.
+ */
+static int is_timer( ktimer_t *timer ) {
+  uintptr_t offset = ( uintptr_t )timer - ( uintptr_t )timers;
+
+  return offset < timer_count * sizeof( ktimer_t ) && offset % sizeof( ktimer_t ) == 0;
+}
+
+/**
+ * @brief      Whether node a is due before node b.
+ */
+static int node_before( release_node_t *a, release_node_t *b ) {
+  return ( int32_t )( a->at - b->at ) < 0;
+}
+
+static void heap_set( uint32_t pos, release_node_t *node ) {
+  heap[ pos ] = node;
+  node->heap_pos = pos;
+}
+
+/**
+ * @brief      Restore the heap order around pos after its time changed.
+ */
+//@{
+static void heap_sift_up( uint32_t pos ) {
+  release_node_t *node = heap[ pos ];
+
+  while ( pos ) {
+    uint32_t parent = ( pos - 1 ) / 2;
+
+    if ( !node_before( node, heap[ parent ] ) ) {
+      break;
+    }
+    heap_set( pos, heap[ parent ] );
+    pos = parent;
+  }
+  heap_set( pos, node );
+}
+
+static void heap_sift_down( uint32_t pos ) {
+  release_node_t *node = heap[ pos ];
+
+  while ( 1 ) {
+    uint32_t child = 2 * pos + 1;
+
+    if ( child >= heap_len ) {
+      break;
+    }
+    if ( child + 1 < heap_len && node_before( heap[ child + 1 ], heap[ child ] ) ) {
+      child++;
+    }
+    if ( !node_before( heap[ child ], node ) ) {
+      break;
+    }
+    heap_set( pos, heap[ child ] );
+    pos = child;
+  }
+  heap_set( pos, node );
+}
+//@}
+
+static void heap_insert( release_node_t *node ) {
+  heap[ heap_len ] = node;
+  heap_sift_up( heap_len++ );
+}
+
+static void heap_remove( release_node_t *node ) {
+  uint32_t pos = node->heap_pos;
+  release_node_t *last = heap[ --heap_len ];
+
+  node->heap_pos = -1;
+  if ( pos < heap_len ) {
+    heap_set( pos, last );
+    heap_sift_up( pos );
+    heap_sift_down( last->heap_pos );
+  }
+}
+
+/**
+ * @brief      Hands an expired timer to the highest priority daemon, or
+ *             queues it.
+ */
+static void timer_deliver( ktimer_t *timer ) {
+  if ( daemons ) {
+    uint32_t index = __builtin_ctz( daemons );
+    timer_fire_t *fire = sched_wait_record( index );
+
+    fire->callback = timer->callback;
+    fire->arg = timer->arg;
+    sched_wake( &daemons, index );
+    return;
+  }
+  if ( timer->queued ) {
+    return;
+  }
+
+  int32_t index = timer - timers;
+
+  timer->queued = 1;
+  timer->next = -1;
+  if ( expired_tail < 0 ) {
+    expired_head = index;
+  } else {
+    timers[ expired_tail ].next = index;
+  }
+  expired_tail = index;
+}
+
+/**
+ * @brief      Takes a timer out of the expired queue.
+ */
+static void expired_unlink( ktimer_t *timer ) {
+  int32_t index = timer - timers;
+  int32_t prev = -1;
+
+  for ( int32_t i = expired_head; i >= 0 && i != index; i = timers[ i ].next ) {
+    prev = i;
+  }
+  if ( prev < 0 ) {
+    expired_head = timer->next;
+  } else {
+    timers[ prev ].next = timer->next;
+  }
+  if ( expired_tail == index ) {
+    expired_tail = prev;
+  }
+  timer->queued = 0;
+}
+
+void timer_reset( void ) {
+  timer_count = 0;
+  heap_len = 0;
+  expired_head = -1;
+  expired_tail = -1;
+  daemons = 0;
+}
+
+void timer_rebase( void ) {
+  uint32_t units = sched_release_units();
+
+  for ( uint32_t pos = 0; pos < heap_len; pos++ ) {
+    if ( heap[ pos ]->id >= MAX_THREADS ) {
+      ktimer_t *timer = &timers[ heap[ pos ]->id - MAX_THREADS ];
+
+      timer->node.at = timer->delay * units;
+    }
+  }
+  for ( uint32_t pos = heap_len / 2; pos-- > 0; ) {
+    heap_sift_down( pos );
+  }
+}
+
+void release_schedule( release_node_t *node ) {
+  if ( node->heap_pos < 0 ) {
+    heap_insert( node );
+    return;
+  }
+  heap_sift_up( node->heap_pos );
+  heap_sift_down( node->heap_pos );
+}
+
+void release_cancel( release_node_t *node ) {
+  if ( node->heap_pos >= 0 ) {
+    heap_remove( node );
+  }
+}
+
+void release_expire( uint32_t now ) {
+  while ( heap_len && ( int32_t )( now - heap[ 0 ]->at ) >= 0 ) {
+    release_node_t *node = heap[ 0 ];
+
+    if ( node->id < MAX_THREADS ) {
+      sched_release( node->id );
+      heap_sift_down( 0 );
+      continue;
+    }
+
+    ktimer_t *timer = &timers[ node->id - MAX_THREADS ];
+
+    if ( timer->period ) {
+      node->at += timer->period * sched_release_units();
+      heap_sift_down( 0 );
+    } else {
+      heap_remove( node );
+    }
+    timer_deliver( timer );
+  }
+}
+
+int release_next( uint32_t *at ) {
+  if ( !heap_len ) {
+    return 0;
+  }
+  *at = heap[ 0 ]->at;
+  return 1;
+}
+
+ktimer_t *sys_timer_create( void *callback, void *arg ) {
+  if ( timer_count >= MAX_SW_TIMERS ) {
+    return NULL;
+  }
+
+  ktimer_t *timer = &timers[ timer_count++ ];
+
+  timer->callback = callback;
+  timer->arg = arg;
+  timer->node.id = MAX_THREADS + ( timer - timers );
+  timer->node.heap_pos = -1;
+  timer->next = -1;
+  timer->queued = 0;
+  return timer;
+}
+
+int sys_timer_start( ktimer_t *timer, uint32_t delay, uint32_t period ) {
+  if ( !is_timer( timer ) ) {
+    return -1;
+  }
+
+  int state = save_interrupt_state_and_disable();
+
+  timer->delay = delay;
+  timer->period = period;
+  timer->node.at = sched_release_now() + delay * sched_release_units();
+  release_schedule( &timer->node );
+  sched_release_update();
+  restore_interrupt_state( state );
+  return 0;
+}
+
+int sys_timer_stop( ktimer_t *timer ) {
+  if ( !is_timer( timer ) ) {
+    return -1;
+  }
+
+  int state = save_interrupt_state_and_disable();
+
+  release_cancel( &timer->node );
+  if ( timer->queued ) {
+    expired_unlink( timer );
+  }
+  sched_release_update();
+  restore_interrupt_state( state );
+  return 0;
+}
+
+void *sys_timer_wait( void **arg ) {
+  int state = save_interrupt_state_and_disable();
+  timer_fire_t fire;
+
+  if ( expired_head >= 0 ) {
+    ktimer_t *timer = &timers[ expired_head ];
+
+    expired_unlink( timer );
+    fire.callback = timer->callback;
+    fire.arg = timer->arg;
+  } else if ( sched_sleep( &daemons, &fire, WAIT_FOREVER, &state ) ) {
+    restore_interrupt_state( state );
+    return NULL;
+  }
+  restore_interrupt_state( state );
+
+  *arg = fire.arg;
+  return fire.callback;
+}
@@ -9,20 +9,92 @@
  * 
  */
 
+#include <arm.h>
 #include <timer.h>
 #include <unistd.h>
 #include <stdint.h>
 #include <printk.h>
+#include <clock.h>
+#include <dwt.h>
+#include <syscall_thread.h>
+#include <irq_latency.h>
 
-#define UNUSED __attribute__((unused))
+/** @brief Largest value the 24-bit reload register holds. */
+#define STK_RELOAD_MAX 0x00FFFFFF
 
-int timer_start(UNUSED int frequency){
+/** @brief STK_CTRL CLKSOURCE bit, set for HCLK and clear for HCLK/8. */
+#define STK_CTRL_CLKSOURCE ( 1 << 2 )
+
+/** @brief SysTick registers for timer_sleep(). */
+//@{
+#define STK_CTRL ( ( volatile uint32_t * )0xE000E010 )
+#define STK_LOAD ( ( volatile uint32_t * )0xE000E014 )
+#define STK_CTRL_ENABLE ( 1 << 0 )
+#define STK_CTRL_COUNTFLAG ( 1 << 16 )
+//@}
+
+/** @brief SysTick current value register, counting down to 0. */
+#define STK_VAL ( ( volatile uint32_t * )0xE000E018 )
+
+/**
+ * @brief Shortest count timer_sleep() restarts SysTick with, long enough for
+ * timer_restart() to see VAL leave 0 whatever the counter clock.
+ */
+#define STK_MIN_RESTART 32
+
+/** @brief ICSR and its PENDSTSET bit, set while a tick waits for the handler. */
+//@{
+#define ICSR ( ( volatile uint32_t * )0xE000ED04 )
+#define ICSR_PENDSTSET ( 1 << 26 )
+//@}
+
+/**
+ * @brief Static variable that will be incremented for every millisecond that
+ * passes.
+ * 
+ */
+static uint32_t millis = 0;
+
+/**
+ * @brief SysTick counter clock in Hz and counts per tick, set by timer_start()
+ * and 0 until it succeeds.
+ */
+//@{
+static uint32_t counter_hz = 0;
+static uint32_t tick_counts = 0;
+//@}
+
+/** @brief Core cycles per counter clock, 1 or 8. */
+static uint32_t cycles_per_count = 1;
+
+/**
+ * @brief DWT cycle count when timer_sleep() last stopped SysTick, and the
+ * cycles it has been stopped for that no shortened count has made up yet.
+ * Measuring each stop keeps the tick grid from drifting against the release
+ * timer, whatever code the compiler made of timer_sleep().
+ */
+//@{
+static uint32_t stopped_at = 0;
+static uint32_t stopped_debt = 0;
+//@}
+
+#ifdef IRQ_LATENCY
+/** @brief Whether the next tick's VAL still counts from its reload. */
+static int latency_valid = 0;
+#endif
+
+int timer_start(int frequency){
+
+  if (frequency <= 0) {
+    return -1;
+  }
 
   /**
-   * @brief Define any constants needed for this function.
+   * @brief SysTick counts the processor clock (HCLK), whatever clock_init
+   * configured it to.
    * 
    */
-  static const uint32_t CORE_FREQUENCY_HZ = 84000000;
+  uint32_t core_frequency_hz = clock_get_hclk_hz();
   
   /**
    * @brief According to 4.5.5 of the programming manual, the correct
@@ -40,11 +112,17 @@ int timer_start(UNUSED int frequency){
   // Clear any existing value in the RELOAD value field (bottom 24 bits).
   *STK_RELOAD_ADDR &= 0xFF000000;
   // Compute reload value from frequency.
-  uint32_t STK_RELOAD_VALUE = ((uint32_t)CORE_FREQUENCY_HZ/frequency) - 1;
-  // Mask out only the bottom 24 bit values of the computed reload value so that
-  // we don't overwrite any bits in the reserved space. Should really return an
-  // error if there's some kind of overflow.
-  STK_RELOAD_VALUE &= 0x00FFFFFF;
+  uint32_t STK_RELOAD_VALUE = (core_frequency_hz/frequency) - 1;
+  uint32_t STK_CTRL_VALUE = 0x7; // set last 3 bits to be 111
+  // Slow tick rates (e.g. a 1 Hz scheduler) overflow the 24-bit reload at
+  // HCLK, so fall back to the HCLK/8 reference clock before giving up.
+  if (STK_RELOAD_VALUE > STK_RELOAD_MAX) {
+    STK_RELOAD_VALUE = (core_frequency_hz/8/frequency) - 1;
+    STK_CTRL_VALUE &= ~STK_CTRL_CLKSOURCE;
+  }
+  if (STK_RELOAD_VALUE > STK_RELOAD_MAX || STK_RELOAD_VALUE == 0) {
+    return -1;
+  }
   // Update the reload address field with the new reload value.
   *STK_RELOAD_ADDR |= STK_RELOAD_VALUE;
 
@@ -66,9 +144,18 @@ int timer_start(UNUSED int frequency){
    */
   uint32_t *STK_CTRL_ADDR = (uint32_t *)0xE000E010;
 
-  uint32_t STK_CTRL_VALUE = 0x7; // set last 3 bits to be 111
+  // The tick count restarts with the new rate.
+  millis = 0;
+  counter_hz = ( STK_CTRL_VALUE & STK_CTRL_CLKSOURCE ) ? core_frequency_hz
+                                                       : core_frequency_hz / 8;
+  tick_counts = STK_RELOAD_VALUE + 1;
+  cycles_per_count = core_frequency_hz / counter_hz;
+  stopped_debt = 0;
+#ifdef IRQ_LATENCY
+  latency_valid = 1;
+#endif
 
-  *STK_CTRL_ADDR |= STK_CTRL_VALUE;
+  *STK_CTRL_ADDR = STK_CTRL_VALUE;
 
   return 0;
 }
@@ -103,25 +190,184 @@ void timer_stop(){
 
 }
 
+uint32_t systick_get_millis() {
+  return millis;
+}
+
+uint64_t timer_get_counts( void ) {
+  if ( !tick_counts ) {
+    return 0;
+  }
+
+  // With interrupts off millis cannot move under us, but the counter can
+  // still reload between the reads, and a reload before them leaves the
+  // tick pending rather than counted. Reading VAL on both sides of PENDSTSET
+  // catches both: either the flag is set or the second read is the larger.
+  // A tick begins as VAL reaches 0, when the interrupt pends, so a 0 is
+  // already the next tick even if it was read before the flag showed.
+  int state = save_interrupt_state_and_disable();
+  uint32_t before = *STK_VAL;
+  uint32_t pending = *ICSR & ICSR_PENDSTSET;
+  uint32_t val = *STK_VAL;
+  uint64_t ticks = millis;
+  restore_interrupt_state( state );
+
+  if ( pending || val > before || val == 0 ) {
+    ticks++;
+  }
+  return ticks * tick_counts + ( tick_counts - val ) % tick_counts;
+}
+
+uint32_t timer_get_tick_counts( void ) {
+  return tick_counts;
+}
+
 /**
- * @brief Static variable that will be incremented for every millisecond that
- * passes.
- * 
+ * @brief Stops SysTick for timer_sleep() and notes when.
+ *
+ * @return STK_CTRL before the stop, whose COUNTFLAG the read has cleared.
  */
-static uint32_t millis = 0;
+static uint32_t timer_halt( void ) {
+  uint32_t ctrl = *STK_CTRL;
 
-uint32_t systick_get_millis() {
-  return millis;
+  stopped_at = dwt_get_cycles();
+  *STK_CTRL = ctrl & ~STK_CTRL_ENABLE;
+  return ctrl;
+}
+
+/**
+ * @brief Counter clocks SysTick has missed while stopped so far, to take off
+ * the count it restarts with.
+ */
+static uint32_t timer_stopped_counts( void ) {
+  return ( dwt_get_cycles() - stopped_at + stopped_debt ) / cycles_per_count;
+}
+
+/**
+ * @brief Starts SysTick again after timer_halt().
+ *
+ * @param made_up Counter clocks taken off the restart count, negative if it
+ *                had to be lengthened. The cycles stopped beyond them are
+ *                made up at the next stop.
+ */
+static void timer_resume( uint32_t made_up ) {
+  *STK_CTRL |= STK_CTRL_ENABLE;
+  stopped_debt += dwt_get_cycles() - stopped_at - made_up * cycles_per_count;
+}
+
+/**
+ * @brief Restarts SysTick, stopped by timer_halt(), with count counter clocks
+ * less the time it was stopped for to its next interrupt, and the normal
+ * reload after that.
+ */
+static void timer_restart( uint32_t count ) {
+  uint32_t stopped = timer_stopped_counts();
+  uint32_t load = count > stopped + STK_MIN_RESTART ? count - stopped
+                                                      : STK_MIN_RESTART;
+
+  *STK_LOAD = load - 1;
+  *STK_VAL = 0;
+  timer_resume( count - load );
+  // VAL reads 0 until the first counter clock loads LOAD, and LOAD has to
+  // hold the short count until then.
+  while ( *STK_VAL == 0 );
+  *STK_LOAD = tick_counts - 1;
 }
 
-void systick_c_handler(){
+void timer_sleep( uint32_t max_ticks ) {
+  uint32_t ticks = tick_counts ? ( STK_RELOAD_MAX + 1 ) / tick_counts : 0;
+
+  if ( max_ticks < ticks ) {
+    ticks = max_ticks;
+  }
+  // A single tick is not worth reprogramming for, and a pending one must run.
+  if ( ticks < 2 || ( *ICSR & ICSR_PENDSTSET ) ) {
+    wait_for_interrupt();
+    return;
+  }
+
+  // Stretch the current tick to end on the boundary ticks from now.
+  timer_halt();
+  uint32_t first = *STK_VAL;
+  uint32_t stopped = timer_stopped_counts();
+  if ( first <= stopped + 1 ) {
+    timer_resume( 0 );
+    wait_for_interrupt();
+    return;
+  }
+  first -= stopped;
+  uint32_t window = first + ( ticks - 1 ) * tick_counts;
+  *STK_LOAD = window - 1;
+  *STK_VAL = 0;
+  timer_resume( stopped );
+
+  wait_for_interrupt();
+
+  // Find where in the tick grid the wakeup landed. VAL reads 0 both before
+  // the window is loaded and as it runs out, and once it has run out the
+  // counter goes round the window again.
+  uint32_t ctrl = timer_halt();
+  uint32_t val = *STK_VAL;
+  int expired = ( ctrl & STK_CTRL_COUNTFLAG ) != 0;
+  uint32_t elapsed, remaining;
+
+  if ( expired ) {
+    elapsed = val ? 2 * window - val : window;
+  } else {
+    elapsed = val ? window - val : 0;
+  }
+  if ( elapsed < first ) {
+    remaining = first - elapsed;
+  } else {
+    uint32_t passed = elapsed - first;
+    uint32_t crossed = 1 + passed / tick_counts;
+
+    // The pending interrupt counts the last boundary itself.
+    millis += expired ? crossed - 1 : crossed;
+#ifdef IRQ_LATENCY
+    // Its reload is lost with the restart below.
+    latency_valid = !expired;
+#endif
+    remaining = tick_counts - passed % tick_counts;
+  }
+  timer_restart( remaining );
+}
+
+uint64_t timer_get_us( void ) {
+  uint64_t counts = timer_get_counts();
+
+  if ( !counter_hz ) {
+    return 0;
+  }
+  // Split so the multiply cannot overflow however long the timer has run.
+  return counts / counter_hz * 1000000 +
+         counts % counter_hz * 1000000 / counter_hz;
+}
+
+RAMFUNC void systick_c_handler( uint32_t val, uint32_t *frame,
+                                uint32_t exc_return ){
+
+#ifdef IRQ_LATENCY
+  if ( latency_valid ) {
+    // The tick began as VAL reached 0, see timer_get_counts().
+    irq_latency_record( ( tick_counts - val ) % tick_counts * cycles_per_count,
+                        frame, exc_return );
+  }
+  latency_valid = 1;
+#else
+  ( void )val; ( void )frame; ( void )exc_return;
+#endif
 
   /**
    * @brief Increment millis.
    * 
    */
+  cpu_isr_enter();
   millis++;
 
+  sched_tick(millis);
+  cpu_isr_exit();
+
   // printk("From SysTick Handler!\n");
 
 }
\ No newline at end of file
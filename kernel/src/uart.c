@@ -9,11 +9,14 @@
  */
 
 #include <unistd.h>
+#include <arm.h>
 #include <rcc.h>
 #include <uart.h>
 #include <uart_polling.h>
 #include <nvic.h>
 #include <gpio.h>
+#include <clock.h>
+#include <syscall_thread.h>
 
 #define UNUSED __attribute__((unused))
 
@@ -44,8 +47,12 @@ struct kernel_buffer send;
 /** @brief Enable Bit for UART Config register */
 #define UART_EN (1 << 13)
 
-/** @brief UART Div Value given specific baud rate */
-#define UART_DIV 0x8B
+/**
+ * @brief UART Div value for a given APB1 clock and baud rate. BRR holds
+ * USARTDIV in 12.4 fixed point, which with 16x oversampling is just
+ * pclk / baud, rounded to nearest.
+ */
+#define UART_DIV( pclk, baud ) ( ( ( pclk ) + ( baud ) / 2 ) / ( baud ) )
 
 /** @brief Enable Bit for RCC */
 #define CLOCK_EN (1 << 17)
@@ -66,7 +73,6 @@ struct kernel_buffer send;
 
 
 void uart_init(int baud){
-  (void)baud;
 
     //Initialize uart register map
     struct uart_reg_map *uart = UART2_BASE;
@@ -94,7 +100,7 @@ void uart_init(int baud){
     uart->CR1 |= UART_EN;
 
     //Set Baud Rate Register to UART Div value
-    uart->BRR = UART_DIV;
+    uart->BRR = UART_DIV( clock_get_pclk1_hz(), ( uint32_t )baud );
 
     receive.front = 0;
     receive.back = 0;
@@ -141,9 +147,10 @@ int uart_get_byte(char *c){
 }
 
 //handout has decent description
-void uart_irq_handler(){
+RAMFUNC void uart_irq_handler(){
   struct uart_reg_map *uart = UART2_BASE;
 
+  cpu_isr_enter();
 
   int transmit_empty = uart->SR & TXEIE_EN;
   //can transmit
@@ -192,7 +199,7 @@ void uart_irq_handler(){
   }
   
   nvic_clear_pending(IRQ_ENABLE);
-
+  cpu_isr_exit();
 
 }
 
@@ -1,4 +1,5 @@
 #include <gpio.h>
+#include <clock.h>
 #include <rcc.h>
 #include <unistd.h>
 #include <uart_polling.h>
@@ -20,8 +21,12 @@ struct uart_reg_map {
 /** @brief Enable Bit for UART Config register */
 #define UART_EN (1 << 13)
 
-/** @brief UART Div Value given specific baud rate */
-#define UART_DIV 0x8B
+/**
+ * @brief UART Div value for a given APB1 clock and baud rate. BRR holds
+ * USARTDIV in 12.4 fixed point, which with 16x oversampling is just
+ * pclk / baud, rounded to nearest.
+ */
+#define UART_DIV( pclk, baud ) ( ( ( pclk ) + ( baud ) / 2 ) / ( baud ) )
 
 /** @brief Enable Bit for RCC */
 #define CLOCK_EN (1 << 17)
@@ -45,8 +50,7 @@ struct uart_reg_map {
  * @param baud Baud rate
  */
 void uart_polling_init (int baud){
-    (void)baud;
-
+  
     //Initialize uart register map
     struct uart_reg_map *uart = UART2_BASE;
 
@@ -70,7 +74,7 @@ void uart_polling_init (int baud){
     uart->CR1 |= UART_EN;
 
     //Set Baud Rate Register to UART Div value
-    uart->BRR = UART_DIV;
+    uart->BRR = UART_DIV( clock_get_pclk1_hz(), ( uint32_t )baud );
 
     return;
 }
@@ -10,6 +10,8 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include "../../kernel/include/svc_batch.h"
+#include "../../kernel/include/svc_num.h"
 
 /**
  * @brief      Runs expr, and if it has a non-zero return value, abort program.
@@ -43,9 +45,81 @@
  * @brief      Calls wfi, which is a hint instruction. It will either put the
  *             processor to sleep or spin.
  */
+#ifdef HOST_SIM
+void wait_for_interrupt( void );
+#else
 intrinsic void wait_for_interrupt( void ) {
   __asm volatile( "wfi" );
 }
+#endif
+
+/**
+ * @brief       Sleeps until the next interrupt, like wait_for_interrupt() but
+ *              through the kernel. From an idle thread the kernel also skips
+ *              the SysTick interrupts nothing is due on, so the core stays
+ *              asleep until the next release or timeout.
+ */
+void sleep_till_interrupt( void );
+
+/**
+ * @brief       Reads the kernel's DWT cycle counter. Consecutive calls are one
+ *              SVC round trip apart.
+ *
+ * @return      The core cycle count.
+ */
+uint32_t get_cycles( void );
+
+/**
+ * @brief       Milliseconds since the kernel started its 1 kHz SysTick.
+ *
+ * @return      The tick count.
+ */
+uint32_t _os_get_ticks( void );
+
+/**
+ * @brief       Queues a system call in batch, see svc_batch.h. Arguments the
+ *              call does not take are ignored.
+ *
+ * @param batch     batch to add to
+ * @param svc_num   SVC number from kernel/include/svc_num.h
+ * @param a0-a4     the call's arguments, up to SVC_BATCH_ARGS
+ *
+ * @return      Index of the call's completion in batch->cq, or -1 if the
+ *              batch is full.
+ */
+int batch_add( svc_batch_t *batch, uint32_t svc_num, uintptr_t a0,
+               uintptr_t a1, uintptr_t a2, uintptr_t a3, uintptr_t a4 );
+
+/**
+ * @brief       Runs every call queued in batch with a single SVC. Return
+ *              values are left in batch->cq. The batch is not emptied.
+ *
+ * @param batch     batch to run
+ *
+ * @return      The number of calls run.
+ */
+int batch_submit( svc_batch_t *batch );
+
+/**
+ * @brief       Prints the kernel's per-SVC call counts and latency histograms,
+ *              see kernel/include/svc_stats.h.
+ *
+ * @param reset     clear the statistics after printing when non-zero
+ *
+ * @return      0, or -1 if the kernel was built without SVC_STATS=1.
+ */
+int svc_stats_dump( int reset );
+
+/**
+ * @brief       Prints the kernel's SysTick latency samples: min/avg/max and a
+ *              histogram, per running thread and the worst few with the pc
+ *              they interrupted. See kernel/include/irq_latency.h.
+ *
+ * @param reset     clear the samples after printing when non-zero
+ *
+ * @return      0, or -1 if the kernel was built without IRQ_LATENCY=1.
+ */
+int irq_latency_dump( int reset );
 
 /**
  * @brief       Pretends to do work until the given time is past.
@@ -80,6 +154,16 @@ void print_status_cnt( char *thread_name, int cnt );
 void print_status_prio_cnt( char *thread_name, int cnt );
 //@}
 
+/**
+ * @brief       Prints a top-style table of cpu_stats(): the window's switch
+ *              count and interrupt, idle and main shares, then a row per live
+ *              thread with its C/T, the share C/T allows and the share it
+ *              used.
+ *
+ * @return      0, or -1 if cpu_stats() has nothing yet.
+ */
+int print_cpu_top( void );
+
 /**
  * @brief           Prints out fibonacci numbers mod mod
  *
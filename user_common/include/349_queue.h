@@ -0,0 +1,242 @@
+/** @file   349_queue.h
+ *
+ *  @brief  Lock-free queues for handing data between threads, or between a
+ *          handler and a thread, without system calls.
+ *
+ *          spsc_queue_t has one producer and one consumer and never waits.
+ *          mpsc_queue_t takes any number of producers, which reserve slots
+ *          with LDREX/STREX, and one consumer. Every push and pop moves as
+ *          many elements as fit, up to count, and returns how many it moved.
+ *
+ *          The caller provides the storage, capacity elements of elem_size
+ *          bytes, and capacity must be a power of two. A queue must live in
+ *          memory every thread using it can write.
+ */
+
+#ifndef _349_QUEUE_H_
+#define _349_QUEUE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef HOST_SIM
+#include "../../kernel/host/include/exclusive.h"
+#else
+#include "../../kernel/include/exclusive.h"
+#endif
+
+/**
+ * @brief      Single-producer, single-consumer ring. Positions run freely and
+ *             are masked into the buffer, so full and empty need no spare slot.
+ */
+typedef struct {
+  uint8_t *buffer;         /**< capacity elements */
+  uint32_t elem_size;      /**< Bytes per element */
+  uint32_t mask;           /**< capacity - 1 */
+  volatile uint32_t head;  /**< Next position to pop, written by the consumer */
+  volatile uint32_t tail;  /**< Next position to push, written by the producer */
+} spsc_queue_t;
+
+/**
+ * @brief      Multiple-producer, single-consumer ring.
+ *
+ *             A producer reserves positions by advancing tail, fills them and
+ *             publishes each one by writing position + 1 to its slot's
+ *             sequence word. The consumer stops at the first slot that is not
+ *             published, so a producer preempted between reserving and
+ *             publishing delays the elements after its own but never blocks
+ *             anyone.
+ */
+typedef struct {
+  uint8_t *buffer;         /**< capacity elements */
+  volatile uint32_t *seq;  /**< capacity sequence words */
+  uint32_t elem_size;      /**< Bytes per element */
+  uint32_t mask;           /**< capacity - 1 */
+  volatile uint32_t head;  /**< Next position to pop, written by the consumer */
+  volatile uint32_t tail;  /**< Next position to reserve */
+} mpsc_queue_t;
+
+/**
+ * @brief      Copies count elements between a ring and a flat array, wrapping
+ *             at the end of the ring.
+ */
+//@{
+static inline void queue_copy_in( uint8_t *buffer, uint32_t mask,
+                                   uint32_t elem_size, uint32_t position,
+                                   const uint8_t *elems, uint32_t count ) {
+  uint32_t slot = position & mask;
+  uint32_t first = mask + 1 - slot < count ? mask + 1 - slot : count;
+
+  memcpy( buffer + slot * elem_size, elems, first * elem_size );
+  memcpy( buffer, elems + first * elem_size, ( count - first ) * elem_size );
+}
+
+static inline void queue_copy_out( const uint8_t *buffer, uint32_t mask,
+                                   uint32_t elem_size, uint32_t position,
+                                   uint8_t *elems, uint32_t count ) {
+  uint32_t slot = position & mask;
+  uint32_t first = mask + 1 - slot < count ? mask + 1 - slot : count;
+
+  memcpy( elems, buffer + slot * elem_size, first * elem_size );
+  memcpy( elems + first * elem_size, buffer, ( count - first ) * elem_size );
+}
+//@}
+
+/**
+ * @brief      Initializes an empty SPSC queue.
+ *
+ * @param      queue      The queue.
+ * @param      buffer     Storage for capacity elements.
+ * @param[in]  elem_size  Bytes per element.
+ * @param[in]  capacity   Elements, a power of two.
+ *
+ * @return     0 on success, -1 if capacity is not a power of two.
+ */
+static inline int spsc_init( spsc_queue_t *queue, void *buffer,
+                             uint32_t elem_size, uint32_t capacity ) {
+  if ( capacity == 0 || ( capacity & ( capacity - 1 ) ) ) {
+    return -1;
+  }
+  queue->buffer = buffer;
+  queue->elem_size = elem_size;
+  queue->mask = capacity - 1;
+  queue->head = 0;
+  queue->tail = 0;
+  return 0;
+}
+
+/**
+ * @brief      Elements queued. Exact for the consumer, a lower bound of the
+ *             space used for the producer.
+ */
+static inline uint32_t spsc_count( spsc_queue_t *queue ) {
+  return queue->tail - queue->head;
+}
+
+/**
+ * @brief      Pushes up to count elements. Producer only.
+ *
+ * @return     The number pushed, 0 if the queue is full.
+ */
+static inline uint32_t spsc_push( spsc_queue_t *queue, const void *elems,
+                                  uint32_t count ) {
+  uint32_t tail = queue->tail;
+  uint32_t space = queue->mask + 1 - ( tail - queue->head );
+
+  if ( count > space ) {
+    count = space;
+  }
+  // The consumer is done with the slots before it moves head.
+  __sync_synchronize();
+  queue_copy_in( queue->buffer, queue->mask, queue->elem_size, tail, elems, count );
+  __sync_synchronize();
+  queue->tail = tail + count;
+  return count;
+}
+
+/**
+ * @brief      Pops up to count elements, oldest first. Consumer only.
+ *
+ * @return     The number popped, 0 if the queue is empty.
+ */
+static inline uint32_t spsc_pop( spsc_queue_t *queue, void *elems,
+                                 uint32_t count ) {
+  uint32_t head = queue->head;
+  uint32_t used = queue->tail - head;
+
+  if ( count > used ) {
+    count = used;
+  }
+  __sync_synchronize();
+  queue_copy_out( queue->buffer, queue->mask, queue->elem_size, head, elems, count );
+  __sync_synchronize();
+  queue->head = head + count;
+  return count;
+}
+
+/**
+ * @brief      Initializes an empty MPSC queue.
+ *
+ * @param      queue      The queue.
+ * @param      buffer     Storage for capacity elements.
+ * @param      seq        Storage for capacity sequence words.
+ * @param[in]  elem_size  Bytes per element.
+ * @param[in]  capacity   Elements, a power of two.
+ *
+ * @return     0 on success, -1 if capacity is not a power of two.
+ */
+static inline int mpsc_init( mpsc_queue_t *queue, void *buffer, uint32_t *seq,
+                             uint32_t elem_size, uint32_t capacity ) {
+  if ( capacity == 0 || ( capacity & ( capacity - 1 ) ) ) {
+    return -1;
+  }
+  // Slot i is first published as position i + 1.
+  for ( uint32_t i = 0; i < capacity; i++ ) {
+    seq[ i ] = i;
+  }
+  queue->buffer = buffer;
+  queue->seq = seq;
+  queue->elem_size = elem_size;
+  queue->mask = capacity - 1;
+  queue->head = 0;
+  queue->tail = 0;
+  return 0;
+}
+
+/**
+ * @brief      Pushes up to count elements. Any number of producers, threads
+ *             or handlers. The elements of one push stay together.
+ *
+ * @return     The number pushed, 0 if the queue is full.
+ */
+static inline uint32_t mpsc_push( mpsc_queue_t *queue, const void *elems,
+                                  uint32_t count ) {
+  uint32_t tail;
+  uint32_t n;
+
+  // Any exception between the LDREX and the STREX makes the STREX fail, so
+  // the space check and the reservation happen as one.
+  do {
+    tail = load_exclusive_register( ( uint32_t * )&queue->tail );
+    n = queue->mask + 1 - ( tail - queue->head );
+    if ( n > count ) {
+      n = count;
+    }
+    if ( n == 0 ) {
+      clear_exclusive();
+      return 0;
+    }
+  } while ( store_exclusive_register( ( uint32_t * )&queue->tail, tail + n ) );
+
+  __sync_synchronize();
+  queue_copy_in( queue->buffer, queue->mask, queue->elem_size, tail, elems, n );
+  __sync_synchronize();
+  for ( uint32_t i = 0; i < n; i++ ) {
+    queue->seq[ ( tail + i ) & queue->mask ] = tail + i + 1;
+  }
+  return n;
+}
+
+/**
+ * @brief      Pops up to count published elements, oldest first. Consumer
+ *             only.
+ *
+ * @return     The number popped, 0 if none is published.
+ */
+static inline uint32_t mpsc_pop( mpsc_queue_t *queue, void *elems,
+                                 uint32_t count ) {
+  uint32_t head = queue->head;
+  uint32_t n = 0;
+
+  while ( n < count && queue->seq[ ( head + n ) & queue->mask ] == head + n + 1 ) {
+    n++;
+  }
+  __sync_synchronize();
+  queue_copy_out( queue->buffer, queue->mask, queue->elem_size, head, elems, n );
+  // Producers only reuse the slots once head has moved past them.
+  __sync_synchronize();
+  queue->head = head + n;
+  return n;
+}
+
+#endif /* _349_QUEUE_H_ */
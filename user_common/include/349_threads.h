@@ -10,8 +10,10 @@
 #define _SYSCALL_THREAD_H_
 
 #include <stdint.h>
+#include "../../kernel/include/cpu_stats.h"
+#include "../../kernel/include/lock_stats.h"
 
-typedef enum { PER_THREAD = 1, KERNEL_ONLY = 0 } memory_protection_t;
+typedef enum { PER_THREAD = 1, KERNEL_ONLY = 0, SHARED_STACK = 2 } memory_protection_t;
 
 /**
  * @brief      Initialize the thread library
@@ -28,6 +30,13 @@ typedef enum { PER_THREAD = 1, KERNEL_ONLY = 0 } memory_protection_t;
  * @param      memory_protection  If KERNEL_ONLY, then kernel will be
  *                                protected if PER_THREAD, perthread mem
  *                                protection in addition to kernel protection.
+ *                                SHARED_STACK protects like KERNEL_ONLY but
+ *                                runs each period of a thread as a job on one
+ *                                stack shared by all threads. The thread
+ *                                function is called afresh every period and
+ *                                returning, or wait_until_next_period(), ends
+ *                                the job. Jobs may lock mutexes but not sleep,
+ *                                and budgets are not enforced.
  * @param      max_mutexes        max number of mutexes created
  *
  * @return     0 on success or -1 on failure
@@ -79,6 +88,15 @@ int scheduler_start( uint32_t frequency );
  */
 uint32_t get_time( void );
 
+/**
+ * @brief      Get the current time at sub-tick resolution, from the tick count
+ *             and how far SysTick is into the current tick.
+ *
+ * @return     Microseconds since scheduler_start(), wrapping after about 71
+ *             minutes.
+ */
+uint32_t get_time_us( void );
+
 /**
  * @brief      Get the effective priority of the current running thread
  *
@@ -134,4 +152,251 @@ void mutex_lock( mutex_t *mutex );
  */
 void mutex_unlock( mutex_t *mutex );
 
+/**
+ * @brief      Copies out a mutex's acquisition, contention and hold time
+ *             statistics, see kernel/include/lock_stats.h.
+ *
+ * @param      mutex  The mutex.
+ * @param      stats  Where to copy them.
+ * @param      reset  Whether to zero them afterwards.
+ *
+ * @return     0 on success, -1 if mutex is not a mutex.
+ */
+int mutex_stats( mutex_t *mutex, mutex_stats_t *stats, int reset );
+
+/**
+ * @brief      Copies out how long a thread has been blocked, see
+ *             kernel/include/lock_stats.h.
+ *
+ * @param      prio   The thread's priority.
+ * @param      stats  Where to copy them.
+ * @param      reset  Whether to zero them afterwards.
+ *
+ * @return     0 on success, -1 if there is no such thread slot.
+ */
+int thread_block_stats( uint32_t prio, thread_block_stats_t *stats, int reset );
+
+/**
+ * @brief      Copies out how the CPU was shared over the last second or so,
+ *             see kernel/include/cpu_stats.h and print_cpu_top().
+ *
+ * @param      stats  Where to copy it.
+ *
+ * @return     0 on success, -1 until the scheduler has run a quarter second.
+ */
+int cpu_stats( cpu_stats_t *stats );
+
+/**
+ * @brief      Sleeps until futex_wake() on addr, unless *addr != expected.
+ *
+ * @return     0 after sleeping, -1 if *addr had changed. Wakeups may be
+ *             spurious, so always recheck.
+ */
+int futex_wait( volatile uint32_t *addr, uint32_t expected );
+
+/**
+ * @brief      Wakes every thread sleeping in futex_wait() on addr.
+ */
+void futex_wake( volatile uint32_t *addr );
+
+/**
+ * @brief      Mutex that locks and unlocks in user mode when it can.
+ *
+ *             The lock word is taken with LDREX/STREX without a system call
+ *             when it is free, the caller already runs at or above the
+ *             ceiling, so no priority change is due, and the time page shows
+ *             no other thread holding a ceiling at or above the caller's
+ *             priority, so PCP would not block it. Otherwise the caller locks
+ *             the kernel mutex underneath for the ceiling and sleeps in
+ *             futex_wait() while the word is held. Threads only contend for
+ *             the word when its holder gave up the CPU while holding it, and
+ *             such a holder does not raise the system ceiling. Ceiling
+ *             violations are only caught on the kernel path.
+ *
+ *             Must live in memory every user of it can write.
+ */
+typedef struct {
+  volatile uint32_t word;  /**< FAST_MUTEX_FREE, _LOCKED or _CONTENDED */
+  uint32_t ceiling;        /**< The max_prio given to fast_mutex_init() */
+  uint32_t kernel_held;    /**< Whether the holder also locked mutex */
+  mutex_t *mutex;          /**< Kernel mutex for the ceiling */
+} fast_mutex_t;
+
+/**
+ * @brief      States of fast_mutex_t.word.
+ */
+//@{
+#define FAST_MUTEX_FREE      0
+#define FAST_MUTEX_LOCKED    1
+#define FAST_MUTEX_CONTENDED 2
+//@}
+
+/**
+ * @brief      Initializes a fast mutex and the kernel mutex it uses.
+ *
+ * @param      mutex     The mutex.
+ * @param      max_prio  As for mutex_init().
+ *
+ * @return     0 on success, -1 if mutex_init() failed.
+ */
+int fast_mutex_init( fast_mutex_t *mutex, uint32_t max_prio );
+
+/**
+ * @brief      Locks a fast mutex, see fast_mutex_t.
+ */
+void fast_mutex_lock( fast_mutex_t *mutex );
+
+/**
+ * @brief      Unlocks a fast mutex, see fast_mutex_t.
+ */
+void fast_mutex_unlock( fast_mutex_t *mutex );
+
+/**
+ * @brief      Timeout for the waits below that never expires. A timeout of 0
+ *             only polls, any other is in ticks.
+ */
+#define WAIT_FOREVER 0xFFFFFFFFU
+
+/**
+ * @brief      Types for semaphores, event flag groups and message queues,
+ *             opaque to user. Their waiters are woken in priority order.
+ *             A handle the matching init call did not return is refused:
+ *             waits, sends and receives fail at once, and posts, sets and
+ *             clears do nothing.
+ */
+//@{
+typedef void semaphore_t;
+typedef void event_group_t;
+typedef void msg_queue_t;
+//@}
+
+/**
+ * @brief      Creates a counting semaphore.
+ *
+ * @param      count  Tokens it starts with.
+ *
+ * @return     A semaphore handle, NULL if the kernel has none left.
+ */
+semaphore_t *semaphore_init( uint32_t count );
+
+/**
+ * @brief      Takes a token, sleeping until one is posted if there is none.
+ *
+ * @return     0 with the token, -1 on timeout.
+ */
+int semaphore_wait( semaphore_t *sem, uint32_t timeout );
+
+/**
+ * @brief      Gives a token to the highest priority waiter, or keeps it.
+ */
+void semaphore_post( semaphore_t *sem );
+
+/**
+ * @brief      Options for event_group_wait().
+ */
+//@{
+/** Wait for every flag in the mask instead of any of them. */
+#define EVENT_WAIT_ALL 0x1
+/** Clear the flags that satisfied the wait. */
+#define EVENT_CLEAR 0x2
+//@}
+
+/**
+ * @brief      Creates a group of 32 event flags, all clear.
+ *
+ * @return     A group handle, NULL if the kernel has none left.
+ */
+event_group_t *event_group_init( void );
+
+/**
+ * @brief      Sleeps until any, or with EVENT_WAIT_ALL every, flag in mask is
+ *             set.
+ *
+ * @return     The flags in mask that were set, 0 on timeout.
+ */
+uint32_t event_group_wait( event_group_t *event, uint32_t mask,
+                           uint32_t options, uint32_t timeout );
+
+/**
+ * @brief      Sets flags, waking every waiter they satisfy.
+ */
+void event_group_set( event_group_t *event, uint32_t flags );
+
+/**
+ * @brief      Clears flags.
+ */
+void event_group_clear( event_group_t *event, uint32_t flags );
+
+/**
+ * @brief      Creates a queue of capacity messages of msg_size bytes each.
+ *
+ * @return     A queue handle, NULL if the kernel has no room for it.
+ */
+msg_queue_t *msg_queue_init( uint32_t msg_size, uint32_t capacity );
+
+/**
+ * @brief      Copies a message in, sleeping while the queue is full.
+ *
+ * @return     0 once sent, -1 on timeout.
+ */
+int msg_queue_send( msg_queue_t *queue, const void *msg, uint32_t timeout );
+
+/**
+ * @brief      Copies the oldest message out, sleeping while the queue is
+ *             empty.
+ *
+ * @return     0 once received, -1 on timeout.
+ */
+int msg_queue_recv( msg_queue_t *queue, void *msg, uint32_t timeout );
+
+/**
+ * @brief      Software timer, opaque to user. Its callback runs in the timer
+ *             daemon thread, see sw_timer_service_start().
+ */
+typedef void sw_timer_t;
+
+/**
+ * @brief      Creates a stopped timer.
+ *
+ * @return     A timer handle, NULL if the kernel has none left.
+ */
+sw_timer_t *sw_timer_create( void ( *callback )( void * ), void *arg );
+
+/**
+ * @brief      Starts or restarts a timer. Timers started before
+ *             scheduler_start() count from it.
+ *
+ * @param      delay   Ticks to the first expiry.
+ * @param      period  Ticks between later expiries, 0 for a one-shot timer.
+ *
+ * @return     0 on success, -1 if timer is not from sw_timer_create().
+ */
+int sw_timer_start( sw_timer_t *timer, uint32_t delay, uint32_t period );
+
+/**
+ * @brief      Stops a timer, dropping an expiry whose callback has not run.
+ *
+ * @return     0 on success, -1 if timer is not from sw_timer_create().
+ */
+int sw_timer_stop( sw_timer_t *timer );
+
+/**
+ * @brief      Sleeps until a timer expires. The daemon thread's loop, for
+ *             programs that would rather run their own.
+ *
+ * @param      arg   Gets the timer's argument.
+ *
+ * @return     The timer's callback, NULL if this thread cannot sleep.
+ */
+void *sw_timer_wait( void **arg );
+
+/**
+ * @brief      Creates the daemon thread that runs timer callbacks, one at a
+ *             time in expiry order. Its budget bounds the callbacks' work in
+ *             each period like any other thread's.
+ *
+ * @return     0 on success, -1 if the thread cannot be created.
+ */
+int sw_timer_service_start( uint32_t prio, uint32_t C, uint32_t T );
+
 #endif /* _SYSCALL_THREAD_H_ */
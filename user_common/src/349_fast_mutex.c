@@ -0,0 +1,112 @@
+/** @file   349_fast_mutex.c
+ *
+ *  @brief  Mutex that only traps into the kernel when it has to, see
+ *          fast_mutex_t in 349_threads.h.
+ */
+
+#include <stddef.h>
+#include <349_threads.h>
+#include "../../kernel/include/time_page.h"
+
+#ifdef HOST_SIM
+#include "../../kernel/host/include/exclusive.h"
+#else
+#include "../../kernel/include/exclusive.h"
+#endif
+
+/**
+ * @brief      Stores desired in *word if it holds expected.
+ *
+ * @return     The value *word held. Any exception between the LDREX and the
+ *             STREX clears the exclusive monitor, so a context switch only
+ *             causes a retry.
+ */
+static uint32_t compare_and_swap( volatile uint32_t *word, uint32_t expected,
+                                  uint32_t desired ) {
+  uint32_t old;
+
+  do {
+    old = load_exclusive_register( ( uint32_t * )word );
+    if ( old != expected ) {
+      break;
+    }
+  } while ( store_exclusive_register( ( uint32_t * )word, desired ) );
+
+  // Keep the critical section's accesses inside the lock.
+  __sync_synchronize();
+  return old;
+}
+
+/**
+ * @brief      Stores desired in *word.
+ *
+ * @return     The value *word held.
+ */
+static uint32_t swap( volatile uint32_t *word, uint32_t desired ) {
+  uint32_t old;
+
+  __sync_synchronize();
+  do {
+    old = load_exclusive_register( ( uint32_t * )word );
+  } while ( store_exclusive_register( ( uint32_t * )word, desired ) );
+  return old;
+}
+
+/**
+ * @brief      Whether another thread holds a ceiling at or above prio, so that
+ *             PCP could refuse a lock at prio. prio must be a thread priority,
+ *             below 32.
+ */
+static int ceiling_held( uint32_t prio ) {
+  return ( TIME_PAGE->ceilings & ( ( 2U << prio ) - 1 ) ) != 0;
+}
+
+int fast_mutex_init( fast_mutex_t *mutex, uint32_t max_prio ) {
+  mutex->mutex = mutex_init( max_prio );
+  if ( mutex->mutex == NULL ) {
+    return -1;
+  }
+  mutex->word = FAST_MUTEX_FREE;
+  mutex->ceiling = max_prio;
+  mutex->kernel_held = 0;
+  return 0;
+}
+
+void fast_mutex_lock( fast_mutex_t *mutex ) {
+  // get_priority() and the ceilings come from the time page, neither traps.
+  uint32_t prio = get_priority();
+
+  if ( prio <= mutex->ceiling && !ceiling_held( prio ) &&
+       compare_and_swap( &mutex->word, FAST_MUTEX_FREE, FAST_MUTEX_LOCKED ) == FAST_MUTEX_FREE ) {
+    // A thread that ran between the check and the swap may have taken a
+    // ceiling and given up the CPU with it. Leave the word to the kernel path.
+    if ( !ceiling_held( prio ) ) {
+      mutex->kernel_held = 0;
+      return;
+    }
+    if ( swap( &mutex->word, FAST_MUTEX_FREE ) == FAST_MUTEX_CONTENDED ) {
+      futex_wake( &mutex->word );
+    }
+  }
+
+  mutex_lock( mutex->mutex );
+  if ( compare_and_swap( &mutex->word, FAST_MUTEX_FREE, FAST_MUTEX_LOCKED ) != FAST_MUTEX_FREE ) {
+    // The holder is asleep with it. Mark it so the unlock wakes us.
+    while ( swap( &mutex->word, FAST_MUTEX_CONTENDED ) != FAST_MUTEX_FREE ) {
+      futex_wait( &mutex->word, FAST_MUTEX_CONTENDED );
+    }
+    __sync_synchronize();
+  }
+  mutex->kernel_held = 1;
+}
+
+void fast_mutex_unlock( fast_mutex_t *mutex ) {
+  uint32_t kernel_held = mutex->kernel_held;
+
+  if ( swap( &mutex->word, FAST_MUTEX_FREE ) == FAST_MUTEX_CONTENDED ) {
+    futex_wake( &mutex->word );
+  }
+  if ( kernel_held ) {
+    mutex_unlock( mutex->mutex );
+  }
+}
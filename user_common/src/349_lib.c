@@ -1,5 +1,46 @@
 #include <349_threads.h>
 #include <349_lib.h>
+#include "../../kernel/include/time_page.h"
+
+/**
+ * @brief  Read straight from the kernel's time page at TIME_PAGE_ADDR
+ *         instead of trapping, see time_page.h.
+ */
+//@{
+uint32_t get_time( void ) {
+  return TIME_PAGE->ticks;
+}
+
+uint32_t _os_get_ticks( void ) {
+  return TIME_PAGE->ticks;
+}
+
+uint32_t get_priority( void ) {
+  return TIME_PAGE->priority;
+}
+
+uint32_t thread_time( void ) {
+  return TIME_PAGE->thread_time;
+}
+//@}
+
+int batch_add( svc_batch_t *batch, uint32_t svc_num, uintptr_t a0,
+               uintptr_t a1, uintptr_t a2, uintptr_t a3, uintptr_t a4 ) {
+  svc_sqe_t *sqe;
+
+  if ( batch->count >= SVC_BATCH_MAX ) {
+    return -1;
+  }
+
+  sqe = &batch->sq[ batch->count ];
+  sqe->svc_num = svc_num;
+  sqe->args[ 0 ] = a0;
+  sqe->args[ 1 ] = a1;
+  sqe->args[ 2 ] = a2;
+  sqe->args[ 3 ] = a3;
+  sqe->args[ 4 ] = a4;
+  return batch->count++;
+}
 
 void spin_wait( uint32_t ms ) {
   uint32_t targetTime = thread_time() + ms;
@@ -73,6 +114,46 @@ void print_status_prio_cnt( char *thread_name, int cnt ) {
   );
 }
 
+/**
+ * @brief  Part of whole in tenths of a percent.
+ */
+static unsigned int per_mille( uint32_t part, uint32_t whole ) {
+  return whole ? ( unsigned int )( ( uint64_t )part * 1000 / whole ) : 0;
+}
+
+int print_cpu_top( void ) {
+  static cpu_stats_t stats;
+  unsigned int pm;
+
+  if ( cpu_stats( &stats ) ) {
+    return -1;
+  }
+
+  printf( "top: %ums, %u switches", ( unsigned int ) ( stats.window_us / 1000 ),
+          ( unsigned int ) stats.switches );
+  pm = per_mille( stats.isr_us, stats.window_us );
+  printf( ", irq %u.%u%%", pm / 10, pm % 10 );
+  pm = per_mille( stats.idle_us, stats.window_us );
+  printf( ", idle %u.%u%%", pm / 10, pm % 10 );
+  pm = per_mille( stats.main_us, stats.window_us );
+  printf( ", main %u.%u%%\n", pm / 10, pm % 10 );
+
+  printf( "prio\tC/T\twant\tused\tswitches\n" );
+  for ( int i = 0; i < CPU_STATS_THREADS; i++ ) {
+    cpu_thread_stats_t *t = &stats.threads[ i ];
+    unsigned int want = per_mille( t->C, t->T );
+
+    if ( t->C == 0 ) {
+      continue;
+    }
+    pm = per_mille( t->run_us, stats.window_us );
+    printf( "%d\t%u/%u\t%u.%u%%\t%u.%u%%\t%u\n", i, ( unsigned int ) t->C,
+            ( unsigned int ) t->T, want / 10, want % 10, pm / 10, pm % 10,
+            ( unsigned int ) t->switches );
+  }
+  return 0;
+}
+
 uint32_t print_fibs( int limit, int interval, uint32_t mod) {
 
   if ( interval == 0 ) interval = 1;
@@ -85,7 +166,7 @@ uint32_t print_fibs( int limit, int interval, uint32_t mod) {
     c = (a + b) % mod;
 
     if ( i % interval == 0 ) {
-      printf("Fib[ %d ] = %lu (mod %lu)\n", i, c, mod);
+      printf("Fib[ %d ] = %lu (mod %lu)\n", i, (unsigned long)c, (unsigned long)mod);
     }
 
     a = b;
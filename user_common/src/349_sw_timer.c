@@ -0,0 +1,25 @@
+/** @file   349_sw_timer.c
+ *
+ *  @brief  Daemon thread for the kernel's software timers, see sw_timer_t in
+ *          349_threads.h.
+ */
+
+#include <stddef.h>
+#include <349_threads.h>
+
+/**
+ * @brief      Runs each expired timer's callback, until it cannot sleep.
+ */
+static void sw_timer_daemon( void *vargp ) {
+  void ( *callback )( void * );
+  void *arg;
+
+  ( void )vargp;
+  while ( ( callback = ( void ( * )( void * ) )sw_timer_wait( &arg ) ) != NULL ) {
+    callback( arg );
+  }
+}
+
+int sw_timer_service_start( uint32_t prio, uint32_t C, uint32_t T ) {
+  return thread_create( &sw_timer_daemon, prio, C, T, NULL );
+}
@@ -1,5 +1,22 @@
 #include </tmp/349_arg.h>
 #include <stdlib.h>
+#include <stdio.h>
+
+/**
+ * @brief stdout buffering, set by STDOUT_BUFFERING and STDOUT_BUFFER_SIZE in
+ * the Makefile. A full buffer turns a burst of prints into one write() SVC but
+ * only shows output once it fills or the program exits.
+ */
+//@{
+#ifndef STDOUT_BUFFERING
+#define STDOUT_BUFFERING _IOLBF
+#endif
+#ifndef STDOUT_BUFFER_SIZE
+#define STDOUT_BUFFER_SIZE 256
+#endif
+
+static char stdout_buffer[ STDOUT_BUFFER_SIZE ];
+//@}
 
 extern int main( int argc, char const *argv[] );
 
@@ -11,6 +28,8 @@ extern int main( int argc, char const *argv[] );
  */
 
 void __attribute__ ( ( noinline ) ) crt0() {
+  setvbuf( stdout, STDOUT_BUFFERING == _IONBF ? NULL : stdout_buffer,
+           STDOUT_BUFFERING, STDOUT_BUFFER_SIZE );
   int ret_val = main( user_argc, user_argv );
   // have to spin to ensure uart buffer is flushed
   exit( ret_val );
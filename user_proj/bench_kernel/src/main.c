@@ -0,0 +1,316 @@
+/**
+ * @file    main.c
+ *
+ * @brief   Kernel microbenchmarks, in core cycles from the DWT counter.
+ *
+ *          Every sample is get_cycles() before and after the operation, minus
+ *          the smallest back-to-back get_cycles() difference, so rows other
+ *          than null_svc are net of the measurement itself. Results are
+ *          printed as CSV lines starting with "bench," once every benchmark
+ *          has run:
+ *
+ *            bench,name,samples,min,avg,max
+ *
+ *          Rows for operations the kernel does not support yet (mutex_init()
+ *          returning NULL) report 0 samples. The fast_mutex rows are H taking
+ *          a mutex whose ceiling it already runs at, so they never trap.
+ */
+#include <349_threads.h>
+#include <349_lib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** @brief thread user space stack size - 1KB */
+#define USR_STACK_WORDS 256
+#define NUM_THREADS 12
+#define NUM_MUTEXES 2
+#define CLOCK_FREQUENCY 1000
+
+/** @brief Samples taken for the benchmarks that run from main. */
+#define MAIN_ITERATIONS 100
+/** @brief Threads created for the thread_create benchmark. */
+#define CREATE_ITERATIONS 8
+/** @brief Samples taken for the benchmarks that need a tick per sample. */
+#define SWITCH_ITERATIONS 64
+#define CONTENDED_ITERATIONS 16
+
+/** @brief Calls per batch_submit() sample. */
+#define BATCH_CALLS 4
+
+/** @brief Bytes per write() sample. */
+#define WRITE_BYTES 64
+
+/**
+ * @brief Task set. H measures, L holds the mutex for the handoff case and
+ * the created threads return at once. L's budget is longer than H's period so
+ * it can hold the mutex until H is released.
+ */
+//@{
+#define H_PRIO 0
+#define H_C 1
+#define H_T 3
+#define L_PRIO 1
+#define L_C 4
+#define L_T 20
+#define CREATE_PRIO 2
+#define CREATE_C 1
+#define CREATE_T 10000
+//@}
+
+/**
+ * @brief Running statistics for one benchmark.
+ */
+typedef struct {
+  const char *name;
+  uint32_t samples;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+} bench_t;
+
+/**
+ * @brief Benchmark rows, in the order they are printed.
+ */
+enum {
+  BENCH_NULL_SVC,
+  BENCH_OS_GET_TICKS,
+  BENCH_BATCH,
+  BENCH_WRITE,
+  BENCH_THREAD_CREATE,
+  BENCH_SWITCH,
+  BENCH_MUTEX_LOCK,
+  BENCH_MUTEX_UNLOCK,
+  BENCH_MUTEX_CONTENDED,
+  BENCH_FAST_MUTEX_LOCK,
+  BENCH_FAST_MUTEX_UNLOCK,
+  BENCH_COUNT
+};
+
+static bench_t benches[ BENCH_COUNT ] = {
+  [ BENCH_NULL_SVC ]        = { .name = "null_svc" },
+  [ BENCH_OS_GET_TICKS ]    = { .name = "os_get_ticks" },
+  [ BENCH_BATCH ]           = { .name = "batch_4_get_cycles" },
+  [ BENCH_WRITE ]           = { .name = "write_64" },
+  [ BENCH_THREAD_CREATE ]   = { .name = "thread_create" },
+  [ BENCH_SWITCH ]          = { .name = "wait_until_next_period_switch" },
+  [ BENCH_MUTEX_LOCK ]      = { .name = "mutex_lock_uncontended" },
+  [ BENCH_MUTEX_UNLOCK ]    = { .name = "mutex_unlock_uncontended" },
+  [ BENCH_MUTEX_CONTENDED ] = { .name = "mutex_unlock_to_lock_handoff" },
+  [ BENCH_FAST_MUTEX_LOCK ] = { .name = "fast_mutex_lock_uncontended" },
+  [ BENCH_FAST_MUTEX_UNLOCK ] = { .name = "fast_mutex_unlock_uncontended" },
+};
+
+/** @brief Smallest back-to-back get_cycles() difference. */
+static uint32_t overhead;
+
+/** @brief Which part of the threaded benchmarks is running. */
+static volatile enum { PHASE_SWITCH, PHASE_CONTENDED, PHASE_DONE } phase;
+
+/** @brief Cycle count H took just before giving up the CPU, 0 if none. */
+static volatile uint32_t switch_start;
+
+/** @brief Cycle count L took just before unlocking for H, 0 if none. */
+static volatile uint32_t handoff_start;
+
+static mutex_t *mutex;
+
+static fast_mutex_t fast_mutex;
+static int fast_mutex_ok;
+
+/**
+ * @brief Adds a sample, net of the measurement overhead.
+ */
+static void record( int bench, uint32_t cycles ) {
+  bench_t *b = &benches[ bench ];
+
+  cycles = cycles > overhead ? cycles - overhead : 0;
+  if ( b->samples == 0 || cycles < b->min ) b->min = cycles;
+  if ( cycles > b->max ) b->max = cycles;
+  b->sum += cycles;
+  b->samples++;
+}
+
+static void print_results( void ) {
+  printf( "bench,name,samples,min,avg,max\n" );
+  for ( int i = 0; i < BENCH_COUNT; i++ ) {
+    bench_t *b = &benches[ i ];
+    printf( "bench,%s,%u,%u,%u,%u\n", b->name, ( unsigned int ) b->samples,
+            ( unsigned int ) b->min,
+            ( unsigned int ) ( b->samples ? b->sum / b->samples : 0 ),
+            ( unsigned int ) b->max );
+  }
+}
+
+/**
+ * @brief Null SVC round trip, _os_get_ticks(), a batch of null calls and
+ * write(), from main.
+ */
+static void bench_main( void ) {
+  static char line[ WRITE_BYTES ];
+  static svc_batch_t batch;
+  uint32_t t0, t1;
+
+  // get_cycles() itself is the null SVC. The overhead is still 0 here, so
+  // this row is raw.
+  for ( int i = 0; i < MAIN_ITERATIONS; i++ ) {
+    t0 = get_cycles();
+    t1 = get_cycles();
+    record( BENCH_NULL_SVC, t1 - t0 );
+  }
+  overhead = benches[ BENCH_NULL_SVC ].min;
+
+  for ( int i = 0; i < MAIN_ITERATIONS; i++ ) {
+    t0 = get_cycles();
+    _os_get_ticks();
+    t1 = get_cycles();
+    record( BENCH_OS_GET_TICKS, t1 - t0 );
+  }
+
+  // Compare with BATCH_CALLS times null_svc.
+  for ( int i = 0; i < BATCH_CALLS; i++ ) {
+    batch_add( &batch, SVC_GET_CYCLES, 0, 0, 0, 0, 0 );
+  }
+  for ( int i = 0; i < MAIN_ITERATIONS; i++ ) {
+    t0 = get_cycles();
+    batch_submit( &batch );
+    t1 = get_cycles();
+    record( BENCH_BATCH, t1 - t0 );
+  }
+
+  for ( int i = 0; i < WRITE_BYTES - 1; i++ ) line[ i ] = '.';
+  line[ WRITE_BYTES - 1 ] = '\n';
+  for ( int i = 0; i < MAIN_ITERATIONS; i++ ) {
+    t0 = get_cycles();
+    write( STDOUT_FILENO, line, WRITE_BYTES );
+    t1 = get_cycles();
+    record( BENCH_WRITE, t1 - t0 );
+  }
+}
+
+/**
+ * @brief Created only to be timed.
+ */
+static void created_thread( UNUSED void *vargp ) {
+}
+
+/**
+ * @brief Receives the switch away from H when nothing else is runnable.
+ */
+static void idle_thread( void ) {
+  while ( 1 ) {
+    if ( switch_start ) {
+      uint32_t t1 = get_cycles();
+      record( BENCH_SWITCH, t1 - switch_start );
+      switch_start = 0;
+    }
+    wait_for_interrupt();
+  }
+}
+
+/**
+ * @brief Measuring thread, one sample per period.
+ */
+static void thread_h( UNUSED void *vargp ) {
+  uint32_t t0, t1;
+
+  for ( int i = 0; i < SWITCH_ITERATIONS; i++ ) {
+    switch_start = get_cycles();
+    wait_until_next_period();
+  }
+  switch_start = 0;
+
+  if ( mutex ) {
+    for ( int i = 0; i < MAIN_ITERATIONS; i++ ) {
+      t0 = get_cycles();
+      mutex_lock( mutex );
+      t1 = get_cycles();
+      record( BENCH_MUTEX_LOCK, t1 - t0 );
+
+      t0 = get_cycles();
+      mutex_unlock( mutex );
+      t1 = get_cycles();
+      record( BENCH_MUTEX_UNLOCK, t1 - t0 );
+    }
+
+    phase = PHASE_CONTENDED;
+    while ( benches[ BENCH_MUTEX_CONTENDED ].samples < CONTENDED_ITERATIONS ) {
+      wait_until_next_period();
+      // L ran at the mutex's ceiling across this release, so H only gets here
+      // once L's unlock lets it preempt.
+      mutex_lock( mutex );
+      t1 = get_cycles();
+      mutex_unlock( mutex );
+      if ( handoff_start ) {
+        record( BENCH_MUTEX_CONTENDED, t1 - handoff_start );
+        handoff_start = 0;
+      }
+    }
+  }
+
+  if ( fast_mutex_ok ) {
+    for ( int i = 0; i < MAIN_ITERATIONS; i++ ) {
+      t0 = get_cycles();
+      fast_mutex_lock( &fast_mutex );
+      t1 = get_cycles();
+      record( BENCH_FAST_MUTEX_LOCK, t1 - t0 );
+
+      t0 = get_cycles();
+      fast_mutex_unlock( &fast_mutex );
+      t1 = get_cycles();
+      record( BENCH_FAST_MUTEX_UNLOCK, t1 - t0 );
+    }
+  }
+
+  phase = PHASE_DONE;
+  print_results();
+  exit( 0 );
+}
+
+/**
+ * @brief Holds the mutex across H's next release in the handoff phase, and
+ * stays out of the way otherwise.
+ */
+static void thread_l( UNUSED void *vargp ) {
+  while ( 1 ) {
+    // A switch to L instead of idle would make a bad sample.
+    switch_start = 0;
+
+    if ( phase == PHASE_CONTENDED ) {
+      uint32_t now = get_time();
+      uint32_t h_release = ( now / H_T + 1 ) * H_T;
+
+      mutex_lock( mutex );
+      while ( get_time() < h_release );
+      handoff_start = get_cycles();
+      mutex_unlock( mutex );
+    }
+
+    wait_until_next_period();
+  }
+}
+
+int main( UNUSED int argc, UNUSED char *const argv[] ) {
+  uint32_t t0, t1;
+
+  bench_main();
+
+  ABORT_ON_ERROR( thread_init( NUM_THREADS, USR_STACK_WORDS, &idle_thread, KERNEL_ONLY, NUM_MUTEXES ) );
+  mutex = mutex_init( H_PRIO );
+  fast_mutex_ok = fast_mutex_init( &fast_mutex, H_PRIO ) == 0;
+
+  for ( int i = 0; i < CREATE_ITERATIONS; i++ ) {
+    t0 = get_cycles();
+    int created = thread_create( &created_thread, CREATE_PRIO + i, CREATE_C, CREATE_T, NULL );
+    t1 = get_cycles();
+    ABORT_ON_ERROR( created );
+    record( BENCH_THREAD_CREATE, t1 - t0 );
+  }
+
+  ABORT_ON_ERROR( thread_create( &thread_h, H_PRIO, H_C, H_T, NULL ) );
+  ABORT_ON_ERROR( thread_create( &thread_l, L_PRIO, L_C, L_T, NULL ) );
+
+  ABORT_ON_ERROR( scheduler_start( CLOCK_FREQUENCY ) );
+
+  return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file  main.c
+ *
+ * @brief Test of fast_mutex_t: the contended futex_wait()/futex_wake() path,
+ *        and a fast lock PCP would refuse going through the kernel instead.
+ *
+ *        Threads 0 and 2 have a period of 400 ticks, thread 1 of 200. In the
+ *        first period thread 0 fast-locks fa (ceiling 0) and runs out of
+ *        budget holding it. Thread 1 then locks fa through the kernel mutex,
+ *        finds the word held and sleeps in futex_wait() until thread 0
+ *        unlocks at t=400.
+ *
+ *        Thread 2 then locks the kernel mutex x (ceiling 1) and also runs out
+ *        of budget holding it. At t=600 thread 1 locks fa2 (ceiling 1), which
+ *        PCP refuses while thread 2 holds ceiling 1, so it must block in the
+ *        kernel rather than take the word. At t=800 thread 2 locks fa2 itself
+ *        before unlocking x. Had thread 1 taken the word, it would wait on x
+ *        and thread 2 on the word, for good.
+ *
+ * @note expected output:
+ * Starting scheduler...
+ * 0 locked fa
+ * 1 locking fa
+ * 0 unlocking fa
+ * 1 locked fa, contended
+ * 2 locked x
+ * 1 locking fa2
+ * 2 locked fa2
+ * 1 locked fa2 and x
+ * Test passed!
+ */
+
+#include <349_lib.h>
+#include <349_threads.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** @brief thread user space stack size - 1KB */
+#define USR_STACK_WORDS 256
+#define NUM_THREADS 3
+#define NUM_MUTEXES 3
+#define CLOCK_FREQUENCY 100
+
+/** @brief Most steps logged */
+#define LOG_SIZE 16
+
+/** @brief Ceiling 0, contended between threads 0 and 1 */
+static fast_mutex_t fa;
+
+/** @brief Ceiling 1, locked by thread 1 while thread 2 holds x */
+static fast_mutex_t fa2;
+
+/** @brief Ceiling 1, a plain kernel mutex */
+static mutex_t *x;
+
+static const char *steps[ LOG_SIZE ];
+static int num_steps;
+
+static void step( const char *what ) {
+  if ( num_steps < LOG_SIZE ) {
+    steps[ num_steps++ ] = what;
+  }
+}
+
+/** @brief Thread 0: holds fa across the end of its budget. */
+void thread_0( UNUSED void *vargp ) {
+  fast_mutex_lock( &fa );
+  step( "0 locked fa" );
+  spin_wait( 30 );
+  step( "0 unlocking fa" );
+  fast_mutex_unlock( &fa );
+}
+
+/** @brief Thread 1: waits for fa on the word, then for fa2 in the kernel. */
+void thread_1( UNUSED void *vargp ) {
+  int contended;
+
+  step( "1 locking fa" );
+  fast_mutex_lock( &fa );
+  contended = fa.word == FAST_MUTEX_CONTENDED && fa.kernel_held;
+  step( contended ? "1 locked fa, contended" : "1 locked fa, uncontended" );
+  fast_mutex_unlock( &fa );
+  wait_until_next_period();
+
+  step( "1 locking fa2" );
+  fast_mutex_lock( &fa2 );
+  mutex_lock( x );
+  step( "1 locked fa2 and x" );
+  mutex_unlock( x );
+  fast_mutex_unlock( &fa2 );
+
+  for ( int i = 0; i < num_steps; i++ ) {
+    printf( "%s\n", steps[ i ] );
+  }
+  if ( !contended || num_steps != 8 ) {
+    printf( "Test failed\n" );
+    exit( 1 );
+  }
+  printf( "Test passed!\n" );
+  exit( 0 );
+}
+
+/** @brief Thread 2: holds x across the end of its budget, then takes fa2. */
+void thread_2( UNUSED void *vargp ) {
+  wait_until_next_period();
+  mutex_lock( x );
+  step( "2 locked x" );
+  spin_wait( 50 );
+  fast_mutex_lock( &fa2 );
+  step( "2 locked fa2" );
+  fast_mutex_unlock( &fa2 );
+  mutex_unlock( x );
+}
+
+int main( UNUSED int argc, UNUSED char const *argv[] ) {
+  ABORT_ON_ERROR( thread_init( NUM_THREADS, USR_STACK_WORDS, NULL, PER_THREAD,
+                               NUM_MUTEXES ) );
+
+  x = mutex_init( 1 );
+  if ( fast_mutex_init( &fa, 0 ) || fast_mutex_init( &fa2, 1 ) || x == NULL ) {
+    printf( "Failed to create the mutexes\n" );
+    return -1;
+  }
+
+  ABORT_ON_ERROR( thread_create( &thread_0, 0, 20, 400, NULL ) );
+  ABORT_ON_ERROR( thread_create( &thread_1, 1, 60, 200, NULL ) );
+  ABORT_ON_ERROR( thread_create( &thread_2, 2, 30, 400, NULL ) );
+
+  printf( "Starting scheduler...\n" );
+
+  ABORT_ON_ERROR( scheduler_start( CLOCK_FREQUENCY ) );
+
+  return 0;
+}
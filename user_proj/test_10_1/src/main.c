@@ -0,0 +1,271 @@
+/**
+ * @file  main.c
+ *
+ * @brief Test of semaphore, event group and message queue waits: timeouts,
+ *        handoff to the highest priority waiter and the refill of a full
+ *        queue from its blocked senders.
+ *
+ *        Threads 0-2 queue up on each object lowest priority first, staggered
+ *        by timed waits, so a FIFO handoff would wake them in reverse. Thread
+ *        3 checks the timeouts on its own and then drives each phase.
+ *
+ * @note expected output:
+ * Starting scheduler...
+ * semaphore timeout: ok
+ * event timeout: ok
+ * recv timeout: ok
+ * send timeout: ok
+ * polls: ok
+ * bad handles: ok
+ * semaphore handoff: 012
+ * queue handoff: 012
+ * event handoff: 012
+ * queue refill: 200 10 11 12
+ * Test passed!
+ */
+
+#include <349_lib.h>
+#include <349_threads.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** @brief thread user space stack size - 1KB */
+#define USR_STACK_WORDS 256
+#define NUM_THREADS 4
+#define NUM_MUTEXES 0
+#define CLOCK_FREQUENCY 100
+
+/** @brief Waiting threads, priorities 0 to NUM_WAITERS - 1 */
+#define NUM_WAITERS 3
+
+/** @brief Ticks between arrivals, enough to outlast a tick of jitter */
+#define STAGGER 2
+
+/** @brief Ticks the controller gives every waiter to queue up */
+#define SETTLE ( STAGGER * ( NUM_WAITERS + 1 ) )
+
+static semaphore_t *sem;
+static event_group_t *event;
+static event_group_t *never;
+static semaphore_t *unposted;
+static msg_queue_t *recv_queue;
+static msg_queue_t *send_queue;
+
+/** @brief Waiter priorities in the order each handoff reached them */
+static char order[ NUM_WAITERS + 1 ];
+static int order_len;
+
+/** @brief Messages the waiters got through recv_queue */
+static uint32_t received[ NUM_WAITERS ];
+
+/** @brief What msg_queue_send() returned to each blocked sender */
+static int sent[ NUM_WAITERS ];
+
+static int failures;
+
+/** @brief Prints ok, or the detail of a failed check. */
+static void check( const char *name, int ok, uint32_t detail ) {
+  if ( ok ) {
+    printf( "%s: ok\n", name );
+  } else {
+    printf( "%s: FAILED (%lu)\n", name, ( unsigned long )detail );
+    failures++;
+  }
+}
+
+/** @brief Logs a waiter woken by a handoff. */
+static void woken( uint32_t prio ) {
+  order[ order_len++ ] = '0' + prio;
+}
+
+/** @brief Prints and clears the handoff order. */
+static void print_order( const char *name ) {
+  order[ order_len ] = '\0';
+  printf( "%s: %s\n", name, order );
+  if ( order_len != NUM_WAITERS || order[ 0 ] != '0' || order[ 1 ] != '1' ||
+       order[ 2 ] != '2' ) {
+    failures++;
+  }
+  order_len = 0;
+}
+
+/**
+ * @brief Sleeps longer the higher the priority, so that the lowest priority
+ *        waiter reaches the next object first.
+ */
+static void stagger( uint32_t prio ) {
+  event_group_wait( never, 1, 0, STAGGER * ( NUM_WAITERS - prio ) );
+}
+
+/** @brief Sleeps for ticks on a semaphore nobody posts. */
+static void settle( uint32_t ticks ) {
+  if ( semaphore_wait( unposted, ticks ) != -1 ) {
+    failures++;
+  }
+}
+
+/** @brief Threads 0-2: wait on each object in turn. */
+void waiter( void *vargp ) {
+  uint32_t prio = ( uint32_t )( uintptr_t )vargp;
+  uint32_t msg;
+
+  stagger( prio );
+  semaphore_wait( sem, WAIT_FOREVER );
+  woken( prio );
+
+  stagger( prio );
+  msg_queue_recv( recv_queue, &msg, WAIT_FOREVER );
+  received[ prio ] = msg;
+  woken( prio );
+
+  stagger( prio );
+  event_group_wait( event, 0x1, EVENT_CLEAR, WAIT_FOREVER );
+  woken( prio );
+
+  stagger( prio );
+  msg = 10 + prio;
+  sent[ prio ] = msg_queue_send( send_queue, &msg, WAIT_FOREVER );
+}
+
+/**
+ * @brief Checks that a wait returned result after exactly timeout ticks, or
+ *        one more when the wait started late in a tick.
+ */
+static void check_timeout( const char *name, int result, int expected,
+                           uint32_t start, uint32_t timeout ) {
+  uint32_t elapsed = get_time() - start;
+
+  check( name, result == expected && elapsed >= timeout && elapsed <= timeout + 1,
+         elapsed );
+}
+
+/** @brief Thread 3: timeouts, then each handoff. */
+void controller( __attribute__( ( unused ) ) void *vargp ) {
+  event_group_t *partial = event_group_init();
+  msg_queue_t *queue = msg_queue_init( sizeof( uint32_t ), 1 );
+  uint32_t msg = 200;
+  uint32_t start;
+  int polls;
+  int bad;
+
+  // Timeouts, while the waiters are still on their way to sem.
+  start = get_time();
+  check_timeout( "semaphore timeout", semaphore_wait( unposted, 5 ), -1, start, 5 );
+
+  event_group_set( partial, 0x2 );
+  start = get_time();
+  check_timeout( "event timeout",
+                 event_group_wait( partial, 0x3, EVENT_WAIT_ALL, 3 ), 0, start, 3 );
+
+  start = get_time();
+  check_timeout( "recv timeout", msg_queue_recv( queue, &msg, 4 ), -1, start, 4 );
+
+  msg_queue_send( queue, &msg, 0 );
+  start = get_time();
+  check_timeout( "send timeout", msg_queue_send( queue, &msg, 2 ), -1, start, 2 );
+
+  start = get_time();
+  polls = semaphore_wait( unposted, 0 ) == -1 &&
+          event_group_wait( partial, 0x1, 0, 0 ) == 0 &&
+          msg_queue_send( queue, &msg, 0 ) == -1 &&
+          msg_queue_recv( queue, &msg, 0 ) == 0 && msg == 200 &&
+          msg_queue_recv( queue, &msg, 0 ) == -1;
+  check( "polls", polls && get_time() == start, get_time() - start );
+
+  // Handles of the wrong kind, off the pool or not from the kernel at all.
+  msg = 300;
+  semaphore_post( &msg );
+  event_group_set( &msg, 0x1 );
+  event_group_clear( ( char * )event + 1, 0x1 );
+  bad = semaphore_wait( event, WAIT_FOREVER ) == -1 &&
+        semaphore_wait( ( char * )unposted + 4, WAIT_FOREVER ) == -1 &&
+        event_group_wait( queue, 0x1, 0, WAIT_FOREVER ) == 0 &&
+        msg_queue_recv( sem, &msg, WAIT_FOREVER ) == -1 &&
+        msg_queue_send( &msg, &msg, WAIT_FOREVER ) == -1 && msg == 300;
+  check( "bad handles", bad, msg );
+
+  // Each handoff wakes a higher priority thread, which runs at once.
+  settle( SETTLE );
+  for ( int i = 0; i < NUM_WAITERS; i++ ) {
+    semaphore_post( sem );
+  }
+  print_order( "semaphore handoff" );
+
+  settle( SETTLE );
+  for ( msg = 100; msg < 100 + NUM_WAITERS; msg++ ) {
+    msg_queue_send( recv_queue, &msg, 0 );
+  }
+  print_order( "queue handoff" );
+  for ( int i = 0; i < NUM_WAITERS; i++ ) {
+    if ( received[ i ] != 100 + ( uint32_t )i ) {
+      failures++;
+    }
+  }
+
+  settle( SETTLE );
+  for ( int i = 0; i < NUM_WAITERS; i++ ) {
+    event_group_set( event, 0x1 );
+  }
+  print_order( "event handoff" );
+
+  // Fill the queue before the senders get to it.
+  msg = 200;
+  msg_queue_send( send_queue, &msg, 0 );
+  settle( SETTLE );
+  printf( "queue refill:" );
+  for ( int i = 0; i <= NUM_WAITERS; i++ ) {
+    if ( msg_queue_recv( send_queue, &msg, 0 ) != 0 ) {
+      failures++;
+      break;
+    }
+    printf( " %lu", ( unsigned long )msg );
+    if ( msg != ( i ? 10 + ( uint32_t )i - 1 : 200 ) ) {
+      failures++;
+    }
+  }
+  printf( "\n" );
+  for ( int i = 0; i < NUM_WAITERS; i++ ) {
+    if ( sent[ i ] != 0 ) {
+      failures++;
+    }
+  }
+  if ( msg_queue_recv( send_queue, &msg, 0 ) != -1 ) {
+    failures++;
+  }
+
+  if ( failures ) {
+    printf( "Test failed: %d\n", failures );
+    exit( 1 );
+  }
+  printf( "Test passed!\n" );
+  exit( 0 );
+}
+
+int main( UNUSED int argc, UNUSED char const *argv[] ) {
+  ABORT_ON_ERROR( thread_init( NUM_THREADS, USR_STACK_WORDS, NULL, PER_THREAD,
+                               NUM_MUTEXES ) );
+
+  sem = semaphore_init( 0 );
+  event = event_group_init();
+  never = event_group_init();
+  unposted = semaphore_init( 0 );
+  recv_queue = msg_queue_init( sizeof( uint32_t ), NUM_WAITERS );
+  send_queue = msg_queue_init( sizeof( uint32_t ), 1 );
+  if ( sem == NULL || event == NULL || never == NULL || unposted == NULL ||
+       recv_queue == NULL || send_queue == NULL ) {
+    printf( "Failed to create the wait objects\n" );
+    return -1;
+  }
+
+  for ( uint32_t i = 0; i < NUM_WAITERS; i++ ) {
+    ABORT_ON_ERROR( thread_create( &waiter, i, 10, 200, ( void * )( uintptr_t )i ) );
+  }
+  ABORT_ON_ERROR( thread_create( &controller, NUM_WAITERS, 20, 200, NULL ) );
+
+  printf( "Starting scheduler...\n" );
+
+  ABORT_ON_ERROR( scheduler_start( CLOCK_FREQUENCY ) );
+
+  return 0;
+}
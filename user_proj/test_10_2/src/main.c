@@ -0,0 +1,277 @@
+/**
+ * @file  main.c
+ *
+ * @brief Test of the lock-free queues in 349_queue.h.
+ *
+ *        main() first checks on its own that the SPSC ring wraps around and
+ *        moves partial bulk pushes and pops, with 3-byte elements, and that
+ *        an MPSC push takes only the space left. It then checks that the MPSC
+ *        consumer stops at a slot whose producer has not published it yet,
+ *        by holding one sequence word back by hand.
+ *
+ *        Threads 0-2 then push batches of 1, 2 and 3 records into one MPSC
+ *        queue every period and thread 3 pops them. Each producer's records
+ *        must come out in order, every batch in one piece.
+ *
+ * @note expected output:
+ * spsc wraparound: ok
+ * spsc bulk: ok
+ * mpsc full: ok
+ * mpsc publish order: ok
+ * Starting scheduler...
+ * mpsc producers: ok
+ * Test passed!
+ */
+
+#include <349_lib.h>
+#include <349_queue.h>
+#include <349_threads.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** @brief thread user space stack size - 1KB */
+#define USR_STACK_WORDS 256
+#define NUM_THREADS 4
+#define NUM_MUTEXES 0
+#define CLOCK_FREQUENCY 100
+
+/** @brief Ring sizes, both powers of two */
+#define SPSC_CAPACITY 8
+#define MPSC_CAPACITY 16
+
+/** @brief Producers, thread p pushes batches of p + 1 records */
+#define NUM_PRODUCERS 3
+
+/** @brief Batches each producer pushes per period */
+#define BATCHES 2
+
+/** @brief Periods the producers run for */
+#define PERIODS 4
+
+/** @brief A record: producer in the top half, its running count below */
+#define RECORD( p, n ) ( ( ( uint32_t )( p ) << 16 ) | ( n ) )
+
+/** @brief An element whose size is not a multiple of a word */
+typedef struct {
+  uint8_t b[ 3 ];
+} triple_t;
+
+static triple_t spsc_buffer[ SPSC_CAPACITY ];
+static uint32_t mpsc_buffer[ MPSC_CAPACITY ];
+static uint32_t mpsc_seq[ MPSC_CAPACITY ];
+static spsc_queue_t spsc;
+static mpsc_queue_t mpsc;
+
+/** @brief Records each producer has pushed, and thread 3 has popped */
+static uint32_t pushed[ NUM_PRODUCERS ];
+static uint32_t popped[ NUM_PRODUCERS ];
+
+static int failures;
+
+/** @brief Prints ok, or FAILED for a failed check. */
+static void check( const char *name, int ok ) {
+  printf( "%s: %s\n", name, ok ? "ok" : "FAILED" );
+  if ( !ok ) {
+    failures++;
+  }
+}
+
+static triple_t triple( uint32_t n ) {
+  return ( triple_t ){ { n, n + 1, n + 2 } };
+}
+
+static int is_triple( triple_t t, uint32_t n ) {
+  return t.b[ 0 ] == ( uint8_t )n && t.b[ 1 ] == ( uint8_t )( n + 1 ) &&
+         t.b[ 2 ] == ( uint8_t )( n + 2 );
+}
+
+/**
+ * @brief Pushes 5 and pops 3, then pushes 6 across the end of the ring and
+ *        pops all 8, oldest first.
+ */
+static int spsc_wraparound( void ) {
+  triple_t in[ SPSC_CAPACITY ];
+  triple_t out[ SPSC_CAPACITY ];
+  int ok = 1;
+
+  for ( uint32_t i = 0; i < SPSC_CAPACITY; i++ ) {
+    in[ i ] = triple( 10 * i );
+  }
+  ok &= spsc_push( &spsc, in, 5 ) == 5;
+  ok &= spsc_pop( &spsc, out, 3 ) == 3;
+  for ( uint32_t i = 0; i < 3; i++ ) {
+    ok &= is_triple( out[ i ], 10 * i );
+  }
+  ok &= spsc_push( &spsc, in + 2, 6 ) == 6;
+  ok &= spsc_count( &spsc ) == SPSC_CAPACITY;
+  ok &= spsc_pop( &spsc, out, SPSC_CAPACITY ) == SPSC_CAPACITY;
+  for ( uint32_t i = 0; i < 2; i++ ) {
+    ok &= is_triple( out[ i ], 10 * ( i + 3 ) );
+  }
+  for ( uint32_t i = 0; i < 6; i++ ) {
+    ok &= is_triple( out[ i + 2 ], 10 * ( i + 2 ) );
+  }
+  return ok && spsc_count( &spsc ) == 0;
+}
+
+/**
+ * @brief Bulk calls move only what fits: a push into 3 free slots, and pops
+ *        from an empty ring and of more than is queued.
+ */
+static int spsc_bulk( void ) {
+  triple_t in[ SPSC_CAPACITY ];
+  triple_t out[ SPSC_CAPACITY ];
+  int ok = 1;
+
+  for ( uint32_t i = 0; i < SPSC_CAPACITY; i++ ) {
+    in[ i ] = triple( 100 + i );
+  }
+  ok &= spsc_pop( &spsc, out, 1 ) == 0;
+  ok &= spsc_push( &spsc, in, 5 ) == 5;
+  ok &= spsc_push( &spsc, in + 5, 7 ) == 3;
+  ok &= spsc_push( &spsc, in, 1 ) == 0;
+  ok &= spsc_pop( &spsc, out, 6 ) == 6;
+  ok &= spsc_pop( &spsc, out + 6, 6 ) == 2;
+  for ( uint32_t i = 0; i < SPSC_CAPACITY; i++ ) {
+    ok &= is_triple( out[ i ], 100 + i );
+  }
+  return ok;
+}
+
+/**
+ * @brief A push takes only the space left, and none once the ring is full.
+ */
+static int mpsc_full( void ) {
+  uint32_t in[ MPSC_CAPACITY ];
+  uint32_t out[ MPSC_CAPACITY ];
+  int ok = 1;
+
+  for ( uint32_t i = 0; i < MPSC_CAPACITY; i++ ) {
+    in[ i ] = i;
+  }
+  ok &= mpsc_push( &mpsc, in, 10 ) == 10;
+  ok &= mpsc_push( &mpsc, in + 10, 10 ) == MPSC_CAPACITY - 10;
+  ok &= mpsc_push( &mpsc, in, 1 ) == 0;
+  ok &= mpsc_pop( &mpsc, out, MPSC_CAPACITY ) == MPSC_CAPACITY;
+  for ( uint32_t i = 0; i < MPSC_CAPACITY; i++ ) {
+    ok &= out[ i ] == i;
+  }
+  return ok && mpsc_pop( &mpsc, out, 1 ) == 0;
+}
+
+/**
+ * @brief Two pushes of two across the end of the ring, the first held back
+ *        as if its producer had been preempted before publishing. Nothing
+ *        may come out until it is published, then all four in order.
+ */
+static int mpsc_publish_order( void ) {
+  uint32_t in[ 4 ] = { 1, 2, 3, 4 };
+  uint32_t out[ 4 ];
+  uint32_t first;
+  uint32_t published;
+  int ok = 1;
+
+  // Move the ring so the pushes wrap.
+  while ( ( mpsc.tail & mpsc.mask ) != MPSC_CAPACITY - 1 ) {
+    ok &= mpsc_push( &mpsc, in, 1 ) == 1 && mpsc_pop( &mpsc, out, 1 ) == 1;
+  }
+  first = mpsc.tail & mpsc.mask;
+  ok &= mpsc_push( &mpsc, in, 2 ) == 2;
+  ok &= mpsc_push( &mpsc, in + 2, 2 ) == 2;
+
+  published = mpsc.seq[ first ];
+  mpsc.seq[ first ] = published - 1;
+  ok &= mpsc_pop( &mpsc, out, 4 ) == 0;
+  mpsc.seq[ first ] = published;
+  ok &= mpsc_pop( &mpsc, out, 4 ) == 4;
+  for ( uint32_t i = 0; i < 4; i++ ) {
+    ok &= out[ i ] == i + 1;
+  }
+  return ok;
+}
+
+/** @brief Threads 0-2: push batches of prio + 1 records each period. */
+void producer( void *vargp ) {
+  uint32_t p = ( uint32_t )( uintptr_t )vargp;
+  uint32_t batch[ NUM_PRODUCERS ];
+
+  for ( int period = 0; period < PERIODS; period++ ) {
+    for ( int b = 0; b < BATCHES; b++ ) {
+      for ( uint32_t i = 0; i <= p; i++ ) {
+        batch[ i ] = RECORD( p, pushed[ p ] + i );
+      }
+      if ( mpsc_push( &mpsc, batch, p + 1 ) != p + 1 ) {
+        failures++;
+      }
+      pushed[ p ] += p + 1;
+    }
+    wait_until_next_period();
+  }
+}
+
+/** @brief Thread 3: pops and checks every record, then reports. */
+void consumer( UNUSED void *vargp ) {
+  uint32_t records[ MPSC_CAPACITY ];
+  int ok = 1;
+
+  for ( int period = 0; period < PERIODS; period++ ) {
+    uint32_t n = mpsc_pop( &mpsc, records, MPSC_CAPACITY );
+
+    for ( uint32_t i = 0; i < n; i++ ) {
+      uint32_t p = records[ i ] >> 16;
+      uint32_t count = records[ i ] & 0xFFFF;
+
+      if ( p >= NUM_PRODUCERS || count != popped[ p ] ) {
+        ok = 0;
+        break;
+      }
+      // A batch starts at a multiple of its size and runs on unbroken.
+      if ( count % ( p + 1 ) == 0 ) {
+        for ( uint32_t j = 1; j <= p; j++ ) {
+          ok &= i + j < n && records[ i + j ] == RECORD( p, count + j );
+        }
+      }
+      popped[ p ]++;
+    }
+    wait_until_next_period();
+  }
+
+  for ( uint32_t p = 0; p < NUM_PRODUCERS; p++ ) {
+    ok &= popped[ p ] == pushed[ p ] && pushed[ p ] == PERIODS * BATCHES * ( p + 1 );
+  }
+  check( "mpsc producers", ok );
+  if ( failures ) {
+    printf( "Test failed: %d\n", failures );
+    exit( 1 );
+  }
+  printf( "Test passed!\n" );
+  exit( 0 );
+}
+
+int main( UNUSED int argc, UNUSED char const *argv[] ) {
+  ABORT_ON_ERROR( thread_init( NUM_THREADS, USR_STACK_WORDS, NULL, PER_THREAD,
+                               NUM_MUTEXES ) );
+
+  if ( spsc_init( &spsc, spsc_buffer, sizeof( triple_t ), SPSC_CAPACITY ) ||
+       mpsc_init( &mpsc, mpsc_buffer, mpsc_seq, sizeof( uint32_t ), MPSC_CAPACITY ) ) {
+    printf( "Queue init failed\n" );
+    return -1;
+  }
+
+  check( "spsc wraparound", spsc_wraparound() );
+  check( "spsc bulk", spsc_bulk() );
+  check( "mpsc full", mpsc_full() );
+  check( "mpsc publish order", mpsc_publish_order() );
+
+  for ( uint32_t p = 0; p < NUM_PRODUCERS; p++ ) {
+    ABORT_ON_ERROR( thread_create( &producer, p, 5, 50, ( void * )( uintptr_t )p ) );
+  }
+  ABORT_ON_ERROR( thread_create( &consumer, NUM_PRODUCERS, 5, 50, NULL ) );
+
+  printf( "Starting scheduler...\n" );
+
+  ABORT_ON_ERROR( scheduler_start( CLOCK_FREQUENCY ) );
+
+  return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file  main.c
+ *
+ * @brief Test of mutex_stats() and thread_block_stats() on a known PCP
+ *        scenario.
+ *
+ *        Thread 2 locks m (ceiling 0) at t=0 and runs out of budget at t=20
+ *        still holding it. Thread 0 is released at t=200, finds m held and
+ *        waits in mutex_lock() until thread 2 comes back at t=300 and
+ *        unlocks at t=310: one contention and 110 ticks blocked. Thread 1 is
+ *        released at t=300 too, and is blocked by the ceiling for the 10
+ *        ticks thread 2 runs at it. Thread 0 then holds m for 2 ticks.
+ *
+ *        At t=400 thread 1 checks the counts, and the times against the
+ *        cycles per tick thread 2 measured while it held m.
+ *
+ * @note expected output:
+ * Starting scheduler...
+ * mutex counts: ok
+ * mutex hold times: ok
+ * thread 0 blocking: ok
+ * thread 1 blocking: ok
+ * thread 2 blocking: ok
+ * reset: ok
+ * bad arguments: ok
+ * Test passed!
+ */
+
+#include <349_lib.h>
+#include <349_threads.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** @brief thread user space stack size - 1KB */
+#define USR_STACK_WORDS 256
+#define NUM_THREADS 3
+#define NUM_MUTEXES 1
+#define CLOCK_FREQUENCY 100
+
+/** @brief Ticks a measured time may be off by */
+#define SLACK_TICKS 2
+
+/** @brief Ceiling 0, shared by threads 0 and 2 */
+static mutex_t *m;
+
+/** @brief Cycles per tick, measured by thread 2 */
+static uint32_t cycles_per_tick;
+
+static int failures;
+
+static void check( const char *name, int ok ) {
+  printf( "%s: %s\n", name, ok ? "ok" : "FAILED" );
+  if ( !ok ) {
+    failures++;
+  }
+}
+
+/** @brief Whether cycles is within SLACK_TICKS of ticks. */
+static int about( uint64_t cycles, uint32_t ticks ) {
+  uint64_t want = ( uint64_t )ticks * cycles_per_tick;
+  uint64_t slack = ( uint64_t )SLACK_TICKS * cycles_per_tick;
+
+  return cycles + slack >= want && cycles <= want + slack;
+}
+
+/** @brief Thread 0: waits for m at t=200, then holds it for 2 ticks. */
+void thread_0( UNUSED void *vargp ) {
+  wait_until_next_period();
+  mutex_lock( m );
+  spin_wait( 2 );
+  mutex_unlock( m );
+  while ( 1 ) {
+    wait_until_next_period();
+  }
+}
+
+/** @brief Thread 1: ceiling blocked at t=300, checks the stats at t=400. */
+void thread_1( UNUSED void *vargp ) {
+  mutex_stats_t ms;
+  thread_block_stats_t bs[ NUM_THREADS ];
+
+  for ( int i = 0; i < 4; i++ ) {
+    wait_until_next_period();
+  }
+
+  mutex_stats( m, &ms, 0 );
+  for ( int i = 0; i < NUM_THREADS; i++ ) {
+    thread_block_stats( i, &bs[ i ], 0 );
+  }
+
+  check( "mutex counts", ms.acquisitions == 2 && ms.contentions == 1 );
+  check( "mutex hold times",
+         about( ms.max_hold, 310 ) && about( ms.total_hold, 312 ) );
+  check( "thread 0 blocking", bs[ 0 ].blocked_count == 1 &&
+                                about( bs[ 0 ].max_blocked, 110 ) &&
+                                bs[ 0 ].total_blocked == bs[ 0 ].max_blocked &&
+                                bs[ 0 ].max_mutex == 0 );
+  check( "thread 1 blocking", bs[ 1 ].blocked_count == 1 &&
+                                about( bs[ 1 ].max_blocked, 10 ) &&
+                                bs[ 1 ].max_mutex == 0 );
+  check( "thread 2 blocking",
+         bs[ 2 ].blocked_count == 0 && bs[ 2 ].max_mutex == -1 );
+
+  mutex_stats( m, &ms, 1 );
+  thread_block_stats( 0, &bs[ 0 ], 1 );
+  mutex_stats( m, &ms, 0 );
+  thread_block_stats( 0, &bs[ 0 ], 0 );
+  check( "reset", ms.acquisitions == 0 && ms.max_hold == 0 &&
+                    ms.total_hold == 0 && bs[ 0 ].blocked_count == 0 &&
+                    bs[ 0 ].total_blocked == 0 && bs[ 0 ].max_mutex == -1 );
+
+  check( "bad arguments",
+         mutex_stats( ( mutex_t * )&ms, &ms, 0 ) == -1 &&
+           thread_block_stats( NUM_THREADS, &bs[ 0 ], 0 ) == -1 );
+
+  if ( failures ) {
+    printf( "Test failed\n" );
+    exit( 1 );
+  }
+  printf( "Test passed!\n" );
+  exit( 0 );
+}
+
+/** @brief Thread 2: holds m across the end of its first budget. */
+void thread_2( UNUSED void *vargp ) {
+  mutex_lock( m );
+  uint32_t start_cycles = get_cycles();
+  uint32_t start_ticks = get_time();
+  spin_wait( 30 );
+  cycles_per_tick = ( get_cycles() - start_cycles ) / ( get_time() - start_ticks );
+  mutex_unlock( m );
+  while ( 1 ) {
+    wait_until_next_period();
+  }
+}
+
+int main( UNUSED int argc, UNUSED char const *argv[] ) {
+  ABORT_ON_ERROR( thread_init( NUM_THREADS, USR_STACK_WORDS, NULL, PER_THREAD,
+                               NUM_MUTEXES ) );
+
+  m = mutex_init( 0 );
+  if ( m == NULL ) {
+    printf( "Failed to create the mutex\n" );
+    return -1;
+  }
+
+  ABORT_ON_ERROR( thread_create( &thread_0, 0, 10, 200, NULL ) );
+  ABORT_ON_ERROR( thread_create( &thread_1, 1, 5, 100, NULL ) );
+  ABORT_ON_ERROR( thread_create( &thread_2, 2, 20, 300, NULL ) );
+
+  printf( "Starting scheduler...\n" );
+
+  ABORT_ON_ERROR( scheduler_start( CLOCK_FREQUENCY ) );
+
+  return 0;
+}
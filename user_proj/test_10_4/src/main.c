@@ -0,0 +1,178 @@
+/**
+ * @file  main.c
+ *
+ * @brief Test of SHARED_STACK jobs: nested preemption on the shared stack and
+ *        a job preempted while it holds a mutex.
+ *
+ *        Thread 2 is a long job that holds a mutex of ceiling 1 through its
+ *        middle third. Thread 1 is released every 25 ticks, and thread 0
+ *        every 7, so thread 0 often lands on thread 1 while thread 1 has
+ *        preempted thread 2. Thread 0 is above the ceiling and may preempt
+ *        the holder, thread 1 is not and has to wait for the unlock.
+ *
+ *        Every job notes where its frame is on the shared stack. A nested job
+ *        has to sit below the ones it preempted, which is only checked on the
+ *        board, since the host simulator runs each job on a stack of its own.
+ *        Thread 2 checks that a buffer on its own frame comes through every
+ *        preemption untouched, and prints the result after its third job.
+ *
+ * @note expected output:
+ * Starting scheduler...
+ * nested preemption: ok
+ * nested frames: ok
+ * preempted holding the mutex: ok
+ * ceiling held off thread 1: ok
+ * frame intact: ok
+ * Test passed!
+ */
+
+#include <349_lib.h>
+#include <349_threads.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** @brief thread user space stack size - 1KB */
+#define USR_STACK_WORDS 256
+#define NUM_THREADS 3
+#define NUM_MUTEXES 1
+#define CLOCK_FREQUENCY 1000
+
+/** @brief Thread 2 jobs before the result is printed */
+#define LOW_JOBS 3
+
+/** @brief Words of thread 2's frame checked across preemptions */
+#define PATTERN_WORDS 32
+
+static mutex_t *mutex;
+
+/** @brief Threads with a live job, one bit per priority */
+static volatile uint32_t live;
+
+/** @brief Frame address of each thread's current job */
+static volatile uintptr_t frame[ NUM_THREADS ];
+
+/** @brief Whether thread 2 holds the mutex */
+static volatile int holding;
+
+/** @brief Thread 0 jobs that found both other jobs live */
+static volatile uint32_t nested;
+
+/** @brief Nested thread 0 jobs whose frame was not below both others */
+static volatile uint32_t misplaced;
+
+/** @brief Thread 0 jobs that preempted the mutex holder */
+static volatile uint32_t preempted_holder;
+
+/** @brief Thread 1 jobs that started while thread 2 held the mutex */
+static volatile uint32_t started_under_ceiling;
+
+/** @brief Thread 2 jobs whose frame was overwritten */
+static volatile uint32_t corrupted;
+
+static int failures;
+
+/** @brief Prints ok, or FAILED for a failed check. */
+static void check( const char *name, int ok ) {
+  printf( "%s: %s\n", name, ok ? "ok" : "FAILED" );
+  if ( !ok ) {
+    failures++;
+  }
+}
+
+/** @brief Thread 0: short, above the ceiling. */
+void high( UNUSED void *vargp ) {
+  volatile uint32_t local = 0;
+
+  frame[ 0 ] = ( uintptr_t )&local;
+  if ( ( live & 0x6 ) == 0x6 ) {
+    nested++;
+#ifndef HOST_SIM
+    // The simulator gives every job a stack of its own.
+    if ( !( frame[ 0 ] < frame[ 1 ] && frame[ 1 ] < frame[ 2 ] ) ) {
+      misplaced++;
+    }
+#endif
+  }
+  if ( holding ) {
+    preempted_holder++;
+  }
+  spin_wait( 1 );
+}
+
+/** @brief Thread 1: a job on the mutex's ceiling. */
+void mid( UNUSED void *vargp ) {
+  volatile uint32_t local = 0;
+
+  frame[ 1 ] = ( uintptr_t )&local;
+  live |= 1 << 1;
+  if ( holding ) {
+    started_under_ceiling++;
+  }
+  spin_wait( 5 );
+  live &= ~( 1 << 1 );
+}
+
+/** @brief Thread 2: long, holds the mutex through its middle. */
+void low( UNUSED void *vargp ) {
+  static uint32_t jobs;
+  volatile uint32_t pattern[ PATTERN_WORDS ];
+
+  frame[ 2 ] = ( uintptr_t )pattern;
+  live |= 1 << 2;
+  for ( uint32_t i = 0; i < PATTERN_WORDS; i++ ) {
+    pattern[ i ] = 0xA5A50000 + i + ( jobs << 8 );
+  }
+
+  spin_wait( 20 );
+  mutex_lock( mutex );
+  holding = 1;
+  spin_wait( 20 );
+  holding = 0;
+  mutex_unlock( mutex );
+  spin_wait( 20 );
+
+  for ( uint32_t i = 0; i < PATTERN_WORDS; i++ ) {
+    if ( pattern[ i ] != 0xA5A50000 + i + ( jobs << 8 ) ) {
+      corrupted++;
+      break;
+    }
+  }
+  live &= ~( 1 << 2 );
+
+  if ( ++jobs < LOW_JOBS ) {
+    return;
+  }
+  check( "nested preemption", nested > 0 );
+  check( "nested frames", misplaced == 0 );
+  check( "preempted holding the mutex", preempted_holder > 0 );
+  check( "ceiling held off thread 1", started_under_ceiling == 0 );
+  check( "frame intact", corrupted == 0 );
+  if ( failures ) {
+    printf( "Test failed: %d\n", failures );
+    exit( 1 );
+  }
+  printf( "Test passed!\n" );
+  exit( 0 );
+}
+
+int main( UNUSED int argc, UNUSED char const *argv[] ) {
+  ABORT_ON_ERROR( thread_init( NUM_THREADS, USR_STACK_WORDS, NULL, SHARED_STACK,
+                               NUM_MUTEXES ) );
+
+  mutex = mutex_init( 1 );
+  if ( mutex == NULL ) {
+    printf( "Failed to create mutex\n" );
+    return -1;
+  }
+
+  ABORT_ON_ERROR( thread_create( &high, 0, 1, 7, NULL ) );
+  ABORT_ON_ERROR( thread_create( &mid, 1, 5, 25, NULL ) );
+  ABORT_ON_ERROR( thread_create( &low, 2, 60, 200, NULL ) );
+
+  printf( "Starting scheduler...\n" );
+
+  ABORT_ON_ERROR( scheduler_start( CLOCK_FREQUENCY ) );
+
+  return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file  main.c
+ *
+ * @brief Test of the software timers and their daemon thread.
+ *
+ *        main() creates five timers before the scheduler starts: a, periodic
+ *        every 30 ticks from t=10; b, a one-shot at t=27; c, periodic every
+ *        20 ticks from t=5; d, started and stopped again at once; and e, a
+ *        one-shot at t=60. The daemon runs at the top priority, so each
+ *        callback logs the tick its timer expired on.
+ *
+ *        Thread 1 checks the time once a period. At t=30 it restarts e for
+ *        t=80, at t=50 it stops c, and at t=120 it checks the log: every
+ *        expiry in order, periodic timers exactly a period apart, and nothing
+ *        from d, from c after it stopped or from e's first start. Handles
+ *        that are not timers are refused.
+ *
+ * @note expected output:
+ * Starting scheduler...
+ * c at 5
+ * a at 10
+ * c at 25
+ * b at 27
+ * a at 40
+ * c at 45
+ * a at 70
+ * e at 80
+ * a at 100
+ * Test passed!
+ */
+
+#include <349_lib.h>
+#include <349_threads.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** @brief thread user space stack size - 1KB */
+#define USR_STACK_WORDS 256
+#define NUM_THREADS 2
+#define NUM_MUTEXES 0
+#define CLOCK_FREQUENCY 100
+
+/** @brief Most expiries logged */
+#define LOG_SIZE 16
+
+/** @brief Tick thread 1 checks the log on */
+#define END_TICKS 120
+
+static sw_timer_t *a, *b, *c, *d, *e;
+
+/** @brief Expiries in the order their callbacks ran */
+//@{
+static char log_name[ LOG_SIZE ];
+static uint32_t log_time[ LOG_SIZE ];
+static int log_len;
+//@}
+
+/** @brief Callback of every timer, arg is its name. */
+static void fired( void *arg ) {
+  if ( log_len < LOG_SIZE ) {
+    log_name[ log_len ] = *( const char * )arg;
+    log_time[ log_len ] = get_time();
+    log_len++;
+  }
+}
+
+/** @brief Thread 1: restarts e, stops c and checks the log. */
+void thread_1( UNUSED void *vargp ) {
+  static const char want_name[] = "cacbacaea";
+  static const uint32_t want_time[] = { 5, 10, 25, 27, 40, 45, 70, 80, 100 };
+  int restarted = 0;
+  int stopped = 0;
+
+  while ( get_time() < END_TICKS ) {
+    if ( !restarted && get_time() >= 30 ) {
+      sw_timer_start( e, 50, 0 );
+      restarted = 1;
+    }
+    if ( !stopped && get_time() >= 50 ) {
+      sw_timer_stop( c );
+      stopped = 1;
+    }
+    wait_until_next_period();
+  }
+
+  int ok = log_len == ( int )sizeof( want_time ) / ( int )sizeof( want_time[ 0 ] );
+
+  for ( int i = 0; i < log_len; i++ ) {
+    printf( "%c at %lu\n", log_name[ i ], ( unsigned long )log_time[ i ] );
+    if ( ok && ( log_name[ i ] != want_name[ i ] || log_time[ i ] != want_time[ i ] ) ) {
+      ok = 0;
+    }
+  }
+  if ( !ok ) {
+    printf( "Test failed\n" );
+    exit( 1 );
+  }
+  printf( "Test passed!\n" );
+  exit( 0 );
+}
+
+int main( UNUSED int argc, UNUSED char const *argv[] ) {
+  ABORT_ON_ERROR( thread_init( NUM_THREADS, USR_STACK_WORDS, NULL, PER_THREAD,
+                               NUM_MUTEXES ) );
+
+  a = sw_timer_create( &fired, "a" );
+  b = sw_timer_create( &fired, "b" );
+  c = sw_timer_create( &fired, "c" );
+  d = sw_timer_create( &fired, "d" );
+  e = sw_timer_create( &fired, "e" );
+  if ( !a || !b || !c || !d || !e ) {
+    printf( "Failed to create the timers\n" );
+    return -1;
+  }
+  ABORT_ON_ERROR( sw_timer_start( a, 10, 30 ) );
+  ABORT_ON_ERROR( sw_timer_start( b, 27, 0 ) );
+  ABORT_ON_ERROR( sw_timer_start( c, 5, 20 ) );
+  ABORT_ON_ERROR( sw_timer_start( d, 15, 15 ) );
+  ABORT_ON_ERROR( sw_timer_stop( d ) );
+  ABORT_ON_ERROR( sw_timer_start( e, 60, 0 ) );
+  if ( sw_timer_start( ( char * )a + 4, 1, 0 ) != -1 || sw_timer_stop( &log_len ) != -1 ) {
+    printf( "Bad timer handle accepted\n" );
+    return -1;
+  }
+
+  ABORT_ON_ERROR( sw_timer_service_start( 0, 5, 10 ) );
+  ABORT_ON_ERROR( thread_create( &thread_1, 1, 2, 10, NULL ) );
+
+  printf( "Starting scheduler...\n" );
+
+  ABORT_ON_ERROR( scheduler_start( CLOCK_FREQUENCY ) );
+
+  return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file  main.c
+ *
+ * @brief Test of cpu_stats() and print_cpu_top() against known budgets.
+ *
+ *        Threads 1 and 2 spin through their whole budget every period, 10
+ *        ticks of 50 and 15 of 100, so each should have run 20% and 15% of
+ *        any window. Thread 0 checks that there is no snapshot before the
+ *        first bucket completes, then takes one at t=250, once a full window
+ *        has gone by, and checks each thread's time, the budgets reported and
+ *        that thread, idle, main and handler times add up to the window.
+ *
+ * @note expected output:
+ * Starting scheduler...
+ * no snapshot yet: ok
+ * window: ok
+ * budgets reported: ok
+ * thread 1 time: ok
+ * thread 2 time: ok
+ * times add up: ok
+ * top: ...
+ * prio    C/T     want    used    switches
+ * 0       5/100   5.0%    ...
+ * 1       10/50   20.0%   ...
+ * 2       15/100  15.0%   ...
+ * print_cpu_top: ok
+ * Test passed!
+ */
+
+#include <349_lib.h>
+#include <349_threads.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** @brief thread user space stack size - 1KB */
+#define USR_STACK_WORDS 256
+#define NUM_THREADS 3
+#define NUM_MUTEXES 0
+#define CLOCK_FREQUENCY 100
+
+/** @brief Tick thread 0 takes its snapshot on */
+#define SNAPSHOT_TICKS 250
+
+static int failures;
+
+static void check( const char *name, int ok ) {
+  printf( "%s: %s\n", name, ok ? "ok" : "FAILED" );
+  if ( !ok ) {
+    failures++;
+  }
+}
+
+/** @brief Whether us is within a tick of want. */
+static int about( uint32_t us, uint32_t want, uint32_t tick_us ) {
+  return us + tick_us >= want && us <= want + tick_us;
+}
+
+/** @brief Threads 1 and 2: use up every budget. */
+void spinner( UNUSED void *vargp ) {
+  while ( 1 ) {
+    spin_wait( 1 );
+  }
+}
+
+/** @brief Thread 0: checks a snapshot against the budgets. */
+void reporter( UNUSED void *vargp ) {
+  static cpu_stats_t stats;
+
+  check( "no snapshot yet", cpu_stats( &stats ) == -1 );
+  while ( get_time() < SNAPSHOT_TICKS ) {
+    wait_until_next_period();
+  }
+
+  if ( cpu_stats( &stats ) ) {
+    printf( "No snapshot\n" );
+    exit( 1 );
+  }
+
+  uint32_t window = stats.window_us;
+  uint32_t tick = stats.tick_us;
+  uint64_t sum = ( uint64_t )stats.idle_us + stats.main_us + stats.isr_us;
+
+  for ( int i = 0; i < CPU_STATS_THREADS; i++ ) {
+    sum += stats.threads[ i ].run_us;
+  }
+
+  check( "window", tick == 1000000 / CLOCK_FREQUENCY &&
+                     about( window, CPU_STATS_BUCKETS * CPU_STATS_BUCKET_US, tick ) );
+  check( "budgets reported",
+         stats.threads[ 0 ].C == 5 && stats.threads[ 0 ].T == 100 &&
+           stats.threads[ 1 ].C == 10 && stats.threads[ 1 ].T == 50 &&
+           stats.threads[ 2 ].C == 15 && stats.threads[ 2 ].T == 100 &&
+           stats.threads[ 3 ].C == 0 );
+  check( "thread 1 time", about( stats.threads[ 1 ].run_us, window / 5, tick ) );
+  check( "thread 2 time",
+         about( stats.threads[ 2 ].run_us, window / 100 * 15, tick ) );
+  check( "times add up", about( sum, window, tick ) );
+  check( "print_cpu_top", print_cpu_top() == 0 );
+
+  if ( failures ) {
+    printf( "Test failed\n" );
+    exit( 1 );
+  }
+  printf( "Test passed!\n" );
+  exit( 0 );
+}
+
+int main( UNUSED int argc, UNUSED char const *argv[] ) {
+  ABORT_ON_ERROR( thread_init( NUM_THREADS, USR_STACK_WORDS, NULL, PER_THREAD,
+                               NUM_MUTEXES ) );
+
+  ABORT_ON_ERROR( thread_create( &reporter, 0, 5, 100, NULL ) );
+  ABORT_ON_ERROR( thread_create( &spinner, 1, 10, 50, NULL ) );
+  ABORT_ON_ERROR( thread_create( &spinner, 2, 15, 100, NULL ) );
+
+  printf( "Starting scheduler...\n" );
+
+  ABORT_ON_ERROR( scheduler_start( CLOCK_FREQUENCY ) );
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file  main.c
+ *
+ * @brief Test that a thread that dies holding mutexes is killed alone and
+ *        its mutexes unlocked, whether it faults or returns.
+ *
+ *        Thread 0 locks m and then runs an undefined instruction. Thread 2
+ *        locks m2 and returns from its function. Thread 1 then has to be able
+ *        to lock both, and to keep running period after period.
+ *
+ * @note expected output:
+ * Starting scheduler...
+ * 0 faulting holding m
+ * Fault ...: UsageFault in thread 0...
+ * Thread 0 killed
+ * 2 returning holding m2
+ * 1 locked m and m2
+ * 1 ran 4 periods
+ * Test passed!
+ */
+
+#include <349_lib.h>
+#include <349_threads.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** @brief thread user space stack size - 1KB */
+#define USR_STACK_WORDS 256
+#define NUM_THREADS 3
+#define NUM_MUTEXES 2
+#define CLOCK_FREQUENCY 100
+
+/** @brief Periods thread 1 runs for after locking both mutexes */
+#define PERIODS 4
+
+/** @brief Ceiling 0, held by thread 0 when it faults */
+static mutex_t *m;
+
+/** @brief Ceiling 1, held by thread 2 when it returns */
+static mutex_t *m2;
+
+/** @brief Thread 0: faults holding m. */
+void thread_0( UNUSED void *vargp ) {
+  mutex_lock( m );
+  printf( "0 faulting holding m\n" );
+  __builtin_trap();
+}
+
+/** @brief Thread 1: locks what the others left behind, then carries on. */
+void thread_1( UNUSED void *vargp ) {
+  int periods = 0;
+
+  wait_until_next_period();
+  mutex_lock( m );
+  mutex_lock( m2 );
+  printf( "1 locked m and m2\n" );
+  mutex_unlock( m2 );
+  mutex_unlock( m );
+
+  while ( periods < PERIODS ) {
+    wait_until_next_period();
+    periods++;
+  }
+  printf( "1 ran %d periods\n", periods );
+  printf( "Test passed!\n" );
+  exit( 0 );
+}
+
+/** @brief Thread 2: returns holding m2. */
+void thread_2( UNUSED void *vargp ) {
+  mutex_lock( m2 );
+  printf( "2 returning holding m2\n" );
+}
+
+int main( UNUSED int argc, UNUSED char const *argv[] ) {
+  ABORT_ON_ERROR( thread_init( NUM_THREADS, USR_STACK_WORDS, NULL, PER_THREAD,
+                               NUM_MUTEXES ) );
+
+  m = mutex_init( 0 );
+  m2 = mutex_init( 1 );
+  if ( m == NULL || m2 == NULL ) {
+    printf( "Failed to create the mutexes\n" );
+    return -1;
+  }
+
+  ABORT_ON_ERROR( thread_create( &thread_0, 0, 5, 50, NULL ) );
+  ABORT_ON_ERROR( thread_create( &thread_1, 1, 5, 50, NULL ) );
+  ABORT_ON_ERROR( thread_create( &thread_2, 2, 5, 50, NULL ) );
+
+  printf( "Starting scheduler...\n" );
+
+  ABORT_ON_ERROR( scheduler_start( CLOCK_FREQUENCY ) );
+
+  return 0;
+}